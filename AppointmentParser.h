@@ -2,7 +2,8 @@
 #define APPOINTMENTPARSER_H
 
 #include "types.h"
-#include "array.h"
+#include "appointmenttable.h"
+#include "dictionary.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -32,7 +33,7 @@ inline Month parseMonth(const std::string& monthStr) {
     throw std::invalid_argument("Unknown month: " + monthStr);
 }
 
-inline void parseAppointmentFile(const std::string& filename, Array<Appointment, 1000>& appointmentArray, std::vector<std::string>& policies) {
+inline void parseAppointmentFile(const std::string& filename, AppointmentStore& appointmentArray) {
     std::ifstream fin(filename);
     std::string line;
     int lineCount = 0;
@@ -53,13 +54,17 @@ inline void parseAppointmentFile(const std::string& filename, Array<Appointment,
         }
 
         std::string cleanPolicy = part1 + part2 + part3 + part4;
+        PolicyId policy;
+        if (!PolicyId::parse(cleanPolicy, policy)) {
+            qDebug().noquote() << QString("Некорректный полис в строке %1").arg(lineCount);
+            continue;
+        }
 
         try {
             Date date = {std::stoi(dayStr), parseMonth(monthStr), std::stoi(yearStr)};
-            Appointment a = {doctor, diagnosis, date};
+            Appointment a = {DoctorTypes.intern(doctor), Diagnoses.intern(diagnosis), date, policy};
 
             if (appointmentArray.Add(a)) {
-                policies.push_back(cleanPolicy);
                 qDebug().noquote() << QString("Загружен приём: [%1, %2, %3 %4 %5], полис: %6")
                                           .arg(QString::fromStdString(doctor))
                                           .arg(QString::fromStdString(diagnosis))
@@ -12,7 +12,7 @@
 std::string trim(const std::string& str);
 Month parseMonth(const std::string& m);
 std::string removeSpaces(const std::string& str);
-bool parsePatientFile(const std::string& filename, Array<Patient, 1000>& patientArray);
+bool parsePatientFile(const std::string& filename, PatientStore& patientArray);
 
 // РЕАЛИЗАЦИИ ФУНКЦИЙ
 
@@ -49,7 +49,7 @@ inline std::string removeSpaces(const std::string& str) {
 }
 
 // 📄 Парсит файл и заполняет массив пациентов
-inline bool parsePatientFile(const std::string& filename, Array<Patient, 1000>& patientArray) {
+inline bool parsePatientFile(const std::string& filename, PatientStore& patientArray) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         qDebug() << "Не удалось открыть файл пациентов:" << QString::fromStdString(filename);
@@ -0,0 +1,83 @@
+#ifndef APPOINTMENTTABLE_H
+#define APPOINTMENTTABLE_H
+
+#include "types.h"
+#include "array.h"
+
+// Поколоночное хранилище приёмов (structure of arrays).
+// Каждое поле лежит в своей плотной сегментированной колонке: дата в
+// упакованном виде (DateKey), номера врача и диагноза в словарях, полис.
+// Фильтры отчётов читают только нужные колонки через date(i) / doctor(i),
+// не поднимая в кэш остальные поля записи.
+// Интерфейс тот же, что у Array<Appointment>: Add / Remove(index, table) /
+// operator[]; operator[] собирает запись из колонок и возвращает её по значению.
+template<std::size_t SegmentSize = 1024>
+class AppointmentTable
+{
+private:
+    Array<DateKey, SegmentSize> m_dates;
+    Array<DictId, SegmentSize> m_doctors;
+    Array<DictId, SegmentSize> m_diagnoses;
+    Array<PolicyId, SegmentSize> m_policies;
+
+public:
+    AppointmentTable() = default;
+
+    AppointmentTable(const AppointmentTable &) = delete;
+    AppointmentTable &operator=(const AppointmentTable &) = delete;
+
+    bool Add(const Appointment &item)
+    {
+        m_dates.Add(item.appointmentDate.toKey());
+        m_doctors.Add(item.doctorId);
+        m_diagnoses.Add(item.diagnosisId);
+        m_policies.Add(item.policy);
+        return true;
+    }
+
+    template <typename HT>
+    bool Remove(std::size_t index, HT &table)
+    {
+        if (index >= Size())
+            return false;
+
+        std::size_t movedIndex = Size() - 1;
+        m_dates.SwapRemove(index);
+        m_doctors.SwapRemove(index);
+        m_diagnoses.SwapRemove(index);
+        m_policies.SwapRemove(index);
+
+        if (index != movedIndex)
+            table.fixIndex(movedIndex, index);
+        return true;
+    }
+
+    void Reserve(std::size_t count)
+    {
+        m_dates.Reserve(count);
+        m_doctors.Reserve(count);
+        m_diagnoses.Reserve(count);
+        m_policies.Reserve(count);
+    }
+
+    Appointment operator[](std::size_t index) const
+    {
+        return {m_doctors[index], m_diagnoses[index],
+                Date::fromKey(m_dates[index]), m_policies[index]};
+    }
+
+    // Доступ к отдельным колонкам
+    DateKey date(std::size_t index) const { return m_dates[index]; }
+    DictId doctor(std::size_t index) const { return m_doctors[index]; }
+    DictId diagnosis(std::size_t index) const { return m_diagnoses[index]; }
+    PolicyId policy(std::size_t index) const { return m_policies[index]; }
+
+    std::size_t Size() const { return m_dates.Size(); }
+    std::size_t GetCapacity() const { return m_dates.GetCapacity(); }
+};
+
+using AppointmentStore = AppointmentTable<>;
+
+extern AppointmentStore AppointmentArray;
+
+#endif // APPOINTMENTTABLE_H
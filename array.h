@@ -2,25 +2,54 @@
 #define ARRAY_H
 
 #include "types.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
 
-
-template<typename T, size_t size>
+// Сегментированное хранилище записей.
+// Данные лежат в сегментах фиксированного размера, при росте добавляется
+// новый сегмент, а уже записанные элементы не копируются и не перемещаются,
+// поэтому адреса записей стабильны. Контракт Add / Remove(index, table) /
+// operator[] прежний: удаление переносит последний элемент в "дыру"
+// и сообщает об этом таблице через fixIndex(movedIndex, index).
+template<typename T, std::size_t SegmentSize = 1024>
 class Array{
+    static_assert(SegmentSize > 0 && (SegmentSize & (SegmentSize - 1)) == 0,
+                  "Размер сегмента должен быть степенью двойки");
+
 private:
-    T data[size];
-    size_t size_;
+    std::vector<std::unique_ptr<T[]>> segments;
+    std::size_t size_;
+
+    static constexpr std::size_t segmentOf(std::size_t index) { return index / SegmentSize; }
+    static constexpr std::size_t offsetOf(std::size_t index) { return index % SegmentSize; }
+
+    T &at(std::size_t index) { return segments[segmentOf(index)][offsetOf(index)]; }
+    const T &at(std::size_t index) const { return segments[segmentOf(index)][offsetOf(index)]; }
 
 public:
     Array(): size_(0){}
 
+    Array(const Array &) = delete;
+    Array &operator=(const Array &) = delete;
+
     bool Add(const T &item)
     {
-        if (size_ < size)
-        {
-            data[size_++] = item;
-            return true;
-        }
-        return false;
+        if (size_ == GetCapacity())
+            segments.push_back(std::make_unique<T[]>(SegmentSize));
+
+        at(size_++) = item;
+        return true;
+    }
+
+    bool Add(T &&item)
+    {
+        if (size_ == GetCapacity())
+            segments.push_back(std::make_unique<T[]>(SegmentSize));
+
+        at(size_++) = std::move(item);
+        return true;
     }
 
     template <typename HT>
@@ -30,28 +59,40 @@ public:
             return false;
 
         size_t movedIndex = size_ - 1;
-        if (index == movedIndex)
-        {
-            --size_;
-            return true;
-        }
+        SwapRemove(index);
+
+        if (index != movedIndex)
+            hashTable.fixIndex(movedIndex, index);
+        return true;
+    }
 
-        data[index] = data[movedIndex];
+    // Удаление без уведомления таблицы: последний элемент переносится в index
+    void SwapRemove(size_t index)
+    {
+        size_t movedIndex = size_ - 1;
+        if (index != movedIndex)
+            at(index) = std::move(at(movedIndex));
+        at(movedIndex) = T{};
         --size_;
+    }
 
-        hashTable.fixIndex(movedIndex, index);
-        return true;
+    // Заранее выделяет сегменты под count записей
+    void Reserve(std::size_t count)
+    {
+        while (GetCapacity() < count)
+            segments.push_back(std::make_unique<T[]>(SegmentSize));
     }
 
-    T &operator[](size_t index) { return data[index]; }
-    const T &operator[](size_t index) const { return data[index]; }
+    T &operator[](size_t index) { return at(index); }
+    const T &operator[](size_t index) const { return at(index); }
 
     size_t Size() const { return size_; }
-    size_t GetCapacity() const { return size; }
+    size_t GetCapacity() const { return segments.size() * SegmentSize; }
+    size_t SegmentCount() const { return segments.size(); }
 };
 
+using PatientStore = Array<Patient>;
 
-extern Array<Patient, 1000> PatientArray;
-extern Array<Appointment, 1000> AppointmentArray;
+extern PatientStore PatientArray;
 
 #endif
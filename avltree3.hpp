@@ -1,28 +1,67 @@
 #ifndef AVLTREE3_HPP
 #define AVLTREE3_HPP
 
-#include "linkedlist.h"
-#include <functional>
+#include "smallvector.h"
+#include "nodearena.h"
+#include "types.h"
 #include <utility>
-#include <QVariant>
+#include "tracelog.h"
+#include "workerpool.h"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Счётчики поддерева для порядковых запросов: ключей (узлов) и записей
+// (сумма длин списков индексов). Без OrderStatistics база пустая
+// и места в узле не занимает.
+template<bool OrderStatistics>
+struct AVLSubtreeCounts {};
+
+template<>
+struct AVLSubtreeCounts<true> {
+    std::size_t subtreeKeys{1};
+    std::size_t subtreeElements{0};
+};
+
+// Индексы записей узла лежат непрерывно: несколько — прямо в узле,
+// длинные списки (даты с десятками приёмов) — в арену списков дерева
+template<typename KeyType, typename T, typename ArrayType, bool OrderStatistics = false>
+struct AVLNode : AVLSubtreeCounts<OrderStatistics> {
+    using IndexList = SmallVector<std::size_t, 4>;
 
-template<typename KeyType, typename T, typename ArrayType>
-struct AVLNode {
     KeyType key;
-    linkedList indexList;
+    IndexList indexList;
     int height;
     AVLNode* left;
     AVLNode* right;
+    AVLNode* parent;
 
-    AVLNode(const KeyType& k) : key(k), height(1), left(nullptr), right(nullptr) {}
+    AVLNode(const KeyType& k) : key(k), height(1), left(nullptr), right(nullptr), parent(nullptr) {}
 };
 
-template<typename KeyType, typename T, typename ArrayType>
+// Allocator — политика выделения узлов (nodearena.h): по умолчанию арена
+// дерева, HeapNodeAllocator — отдельный new/delete на каждый узел.
+// Вставка, удаление, поиск и обходы итеративные: узлы знают родителя,
+// поэтому глубина дерева не расходует стек, а обходы принимают
+// посетителя-шаблон и встраивают его без косвенного вызова.
+// OrderStatistics — узлы хранят счётчики поддерева, и дерево отвечает
+// на rank / select / countInRange за O(log n); повороты и подъём после
+// вставки и удаления поддерживают счётчики.
+template<typename KeyType, typename T, typename ArrayType,
+         template<typename> class Allocator = NodeArena,
+         bool OrderStatistics = false>
 class AVLTree {
 public:
-    using Node = AVLNode<KeyType, T, ArrayType>;
+    using Node = AVLNode<KeyType, T, ArrayType, OrderStatistics>;
 
     struct TreeStatistics {
         int totalNodes;
@@ -31,24 +70,127 @@ public:
         int uniqueKeys;
     };
 
+    // Двунаправленный итератор по узлам в порядке возрастания ключа
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = const Node&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *m_node; }
+        pointer operator->() const { return m_node; }
+
+        const_iterator& operator++() { m_node = successor(m_node); return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+
+        // --end() — наибольший ключ
+        const_iterator& operator--() { m_node = m_node ? predecessor(m_node) : maxNode(m_tree->root); return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+
+        bool operator==(const const_iterator& other) const { return m_node == other.m_node; }
+
+    private:
+        friend class AVLTree;
+        const_iterator(const Node* node, const AVLTree* tree) : m_node(node), m_tree(tree) {}
+
+        const Node* m_node{nullptr};
+        const AVLTree* m_tree{nullptr};
+    };
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // Полуинтервал узлов [first, last) для range-for
+    struct Range {
+        const_iterator first;
+        const_iterator last;
+
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
     AVLTree();
     ~AVLTree();
 
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+
     bool insert(const KeyType& key, const T& value, ArrayType& array);
     bool insertIndex(const KeyType& key, std::size_t index);
-    bool remove(const KeyType& key, const T& value, ArrayType& array);
-    bool removeAllByKey(const KeyType& key);
+    // Убирает из дерева индекс записи, не трогая массив: узел находится
+    // по обратной ссылке, опустевший узел удаляется. Перенос последней
+    // записи массива на место удалённой сообщается через fixIndex.
+    // Массив удаляет владелец: над ним может стоять несколько деревьев,
+    // и fixIndex должны получить все.
+    bool removeIndex(std::size_t index);
     void fixIndex(std::size_t oldIdx, std::size_t newIdx);
 
-    void traverse(std::function<void(const T&, const KeyType&)> callback, const ArrayType& array) const;
-    void traverseFiltered(std::function<bool(const T&)> filter,
-                          std::function<void(const T&)> onAccept,
-                          const ArrayType& array) const;
-    void traverseIndex(std::function<void(std::size_t, const KeyType&)> callback) const;
-    void traverseByKey(const KeyType& key, std::function<void(std::size_t)> callback) const;
-
-
+    // Перестраивает дерево за O(n) из пар (ключ, индекс), упорядоченных по ключу
+    void buildFromSorted(const std::vector<std::pair<KeyType, std::size_t>>& entries);
+
+    const_iterator begin() const { return const_iterator(minNode(root), this); }
+    const_iterator end() const { return const_iterator(nullptr, this); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_iterator find(const KeyType& key) const { return const_iterator(findNode(key), this); }
+
+    // Первый узел с ключом >= key / > key; один спуск от корня
+    const_iterator lowerBound(const KeyType& key) const;
+    const_iterator upperBound(const KeyType& key) const;
+    // Узлы с ключами из отрезка [from, to]: O(log n) на поиск начала и по шагу на узел
+    Range range(const KeyType& from, const KeyType& to) const;
+
+    // Обходы идут справа налево (по убыванию ключа), как показывает интерфейс
+    template<typename Visitor>                  // callback(const T&, const KeyType&)
+    void traverse(Visitor&& callback, const ArrayType& array) const;
+    template<typename Filter, typename Accept>  // filter(const T&) -> bool, onAccept(const T&)
+    void traverseFiltered(Filter&& filter, Accept&& onAccept, const ArrayType& array) const;
+    template<typename Visitor>                  // callback(std::size_t index, const KeyType&)
+    void traverseIndex(Visitor&& callback) const;
+    template<typename Visitor>                  // callback(std::size_t index)
+    void traverseByKey(const KeyType& key, Visitor&& callback) const;
+    template<typename Visitor>                  // callback(std::size_t index, const KeyType&)
+    void traverseRange(const KeyType& from, const KeyType& to, Visitor&& callback) const;
+
+    // Параллельный обход. Дерево режется на независимые поддеревья на глубине
+    // splitDepth (0 — по числу ядер), их разбирают потоки общего пула
+    // (workerpool.h) вместе с вызывающим.
+    // visitor(const Node&, Acc&) копит результат своей части и вызывается из
+    // нескольких потоков сразу; merge(Acc& into, Acc&& part) сливает части.
+    // Ordered — у каждой части свой Acc, слияние в порядке возрастания ключа;
+    // Unordered — по одному Acc на поток (для сумм и счётчиков).
+    enum class MergeOrder { Ordered, Unordered };
+    template<typename Acc, typename Visitor, typename Merge>
+    Acc parallelTraverse(Visitor&& visitor, Merge&& merge,
+                         MergeOrder order = MergeOrder::Ordered, int splitDepth = 0) const;
+    // То же только для узлов с ключами из отрезка [from, to]
+    template<typename Acc, typename Visitor, typename Merge>
+    Acc parallelTraverseRange(const KeyType& from, const KeyType& to, Visitor&& visitor, Merge&& merge,
+                              MergeOrder order = MergeOrder::Ordered, int splitDepth = 0) const;
+    // С начальным аккумулятором: все части сливаются в init (например,
+    // в вектор, память под который выделена заранее)
+    template<typename Acc, typename Visitor, typename Merge>
+    Acc parallelTraverseRange(const KeyType& from, const KeyType& to, Acc init, Visitor&& visitor, Merge&& merge,
+                              MergeOrder order = MergeOrder::Ordered, int splitDepth = 0) const;
+
+    // Порядковые запросы по записям (не по ключам), только с OrderStatistics
+    std::size_t size() const requires OrderStatistics;
+    // Число записей с ключом меньше key
+    std::size_t rank(const KeyType& key) const requires OrderStatistics;
+    // Запись номер k (с нуля) в порядке ключей: узел и позиция в его списке
+    // индексов; {end(), 0}, если k >= size()
+    std::pair<const_iterator, std::size_t> select(std::size_t k) const requires OrderStatistics;
+    // Число записей с ключом из отрезка [from, to]
+    std::size_t countInRange(const KeyType& from, const KeyType& to) const requires OrderStatistics;
+
+    // O(1) для узлов из арены: арены узлов и списков индексов сбрасываются
+    // целиком, их блоки остаются для следующего построения
     void clear();
+    // Очистка с возвратом памяти арен сверх первого блока
+    void release();
     Node* getRoot() const;
     bool isEmpty() const;
 
@@ -59,134 +201,219 @@ public:
     bool validateIntegrity(const ArrayType& array) const;
 
 private:
+    Allocator<Node> nodes;
+    // Списки индексов, не поместившиеся в узел
+    SpillArena<std::size_t> lists;
     Node* root;
-
-    Node* insert(Node* node, const KeyType& key, std::size_t index);
-    Node* removeNode(Node* node, const KeyType& key);
+    // Обратные ссылки: индекс записи массива → узел и позиция в его списке
+    // индексов. По ним fixIndex правит перенесённую запись за O(1), без обхода дерева.
+    struct EntryRef {
+        Node* node;
+        std::uint32_t pos;
+    };
+    std::vector<EntryRef> entryOf;
+
+    void addEntry(Node* node, std::size_t index);
+    void eraseEntry(Node* node, std::size_t pos);
+    Node* unlinkNode(Node* node);
+    Node* linkBalanced(Node* const* sorted, std::size_t count, Node* parent);
+    void rebalanceUp(Node* node);
+    void replaceChild(Node* parent, Node* oldChild, Node* newChild);
     Node* balance(Node* node);
     int getHeight(Node* node) const;
-    void updateHeight(Node* node);
+    void updateNode(Node* node);
+    void updateCountsUp(Node* node);
+    std::size_t countBelow(const KeyType& key, bool inclusive) const;
+    static std::size_t elementsOf(const Node* node);
     int getBalance(Node* node) const;
     Node* rotateLeft(Node* x);
     Node* rotateRight(Node* y);
-    void clear(Node* node);
-    void traverse(Node* node, std::function<void(const T&, const KeyType&)> callback, const ArrayType& array) const;
-    void traverseFiltered(Node* node, std::function<bool(const T&)> filter,
-                          std::function<void(const T&)> onAccept,
-                          const ArrayType& array) const;
-    void traverseIndex(Node* node, std::function<void(std::size_t, const KeyType&)> callback) const;
-
-    Node* findNode(Node* node, const KeyType& key) const;
+
+    Node* findNode(const KeyType& key) const;
+
+    // Часть параллельного обхода: целое поддерево или одиночный узел над глубиной разреза
+    struct Segment {
+        const Node* node;
+        bool whole;
+    };
+    // Меньшие деревья (в том числе для getStatistics и validateIntegrity)
+    // обходятся в вызывающем потоке: передача частей пулу дороже обхода
+    static constexpr int ParallelMinHeight = 12;
+
+    void collectSegments(const Node* node, int depth, int splitDepth,
+                         const KeyType* from, const KeyType* to, std::vector<Segment>& out) const;
+    template<typename Acc, typename Visitor, typename Merge>
+    Acc runParallel(const KeyType* from, const KeyType* to, Acc* init, Visitor& visitor, Merge& merge,
+                    MergeOrder order, int splitDepth) const;
+
+    static Node* minNode(Node* node);
+    static Node* maxNode(Node* node);
+    static const Node* successor(const Node* node);
+    static const Node* predecessor(const Node* node);
 };
 
 // РЕАЛИЗАЦИЯ КОНСТРУКТОРА И ДЕСТРУКТОРА
-template<typename KeyType, typename T, typename ArrayType>
-AVLTree<KeyType, T, ArrayType>::AVLTree() : root(nullptr) {}
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::AVLTree() : root(nullptr) {}
 
-template<typename KeyType, typename T, typename ArrayType>
-AVLTree<KeyType, T, ArrayType>::~AVLTree() {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::~AVLTree() {
     clear();
 }
 
 // РЕАЛИЗАЦИЯ МЕТОДОВ ОЧИСТКИ
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::clear() {
-    qDebug().noquote() << "[clear] Очистка дерева начата";
-    clear(root);
+// Узлы арены не обходятся: они разрушаются тривиально, а вынесенные
+// списки индексов лежат в арене lists. Иначе (HeapNodeAllocator)
+// узлы разрушаются снизу вверх без рекурсии: спускаемся к листу,
+// отцепляем его от родителя и возвращаемся к родителю
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::clear() {
+    TRACE(Info, Tree, "[clear] Очистка дерева начата");
+
+    constexpr bool bulkReset = Allocator<Node>::ResetFreesNodes && std::is_trivially_destructible_v<Node>;
+    Node* node = bulkReset ? nullptr : root;
+    while (node) {
+        if (node->left) {
+            node = node->left;
+        } else if (node->right) {
+            node = node->right;
+        } else {
+            Node* parent = node->parent;
+            if (parent) {
+                if (parent->left == node)
+                    parent->left = nullptr;
+                else
+                    parent->right = nullptr;
+            }
+
+            TRACE(Trace, Tree, "[clear] Удалён узел с ключом: %1", node->key);
+            nodes.destroy(node);
+            node = parent;
+        }
+    }
+
     root = nullptr;
-    qDebug().noquote() << "[clear] Дерево очищено (root = nullptr)";
+    // Арены начинают нарезку с первого блока заново
+    nodes.reset();
+    lists.reset();
+    entryOf.clear();
+    TRACE(Info, Tree, "[clear] Дерево очищено (root = nullptr)");
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::clear(Node* node) {
-    if (!node) return;
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::release() {
+    clear();
+    nodes.release();
+    lists.release();
+    std::vector<EntryRef>().swap(entryOf);
+}
 
-    clear(node->left);
-    clear(node->right);
+// РЕАЛИЗАЦИЯ МЕТОДОВ БАЛАНСИРОВКИ
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+int AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getHeight(Node* node) const {
+    return node ? node->height : 0;
+}
 
-    qDebug().noquote() << "[clear] Удалён узел с ключом:"
-                       << QString::fromStdString(node->key);
+// Пересчитывает высоту и счётчики узла по его детям
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::updateNode(Node* node) {
+    if (!node)
+        return;
 
-    delete node;
+    node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));
+    if constexpr (OrderStatistics) {
+        node->subtreeKeys = 1 + (node->left ? node->left->subtreeKeys : 0)
+                              + (node->right ? node->right->subtreeKeys : 0);
+        node->subtreeElements = node->indexList.size() + elementsOf(node->left) + elementsOf(node->right);
+    }
 }
 
-// РЕАЛИЗАЦИЯ МЕТОДОВ БАЛАНСИРОВКИ
-template<typename KeyType, typename T, typename ArrayType>
-int AVLTree<KeyType, T, ArrayType>::getHeight(Node* node) const {
-    return node ? node->height : 0;
+// Высоты выше node не менялись, но число записей в поддеревьях — да:
+// счётчики правятся до корня (без OrderStatistics ничего не делает)
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::updateCountsUp(Node* node) {
+    if constexpr (OrderStatistics) {
+        for (; node; node = node->parent)
+            updateNode(node);
+    }
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::updateHeight(Node* node) {
-    if (node)
-        node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::size_t AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::elementsOf(const Node* node) {
+    return node ? node->subtreeElements : 0;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-int AVLTree<KeyType, T, ArrayType>::getBalance(Node* node) const {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+int AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getBalance(Node* node) const {
     return node ? getHeight(node->left) - getHeight(node->right) : 0;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::rotateLeft(Node* x) {
+// Повороты переставляют и ссылки на родителя; новый корень поддерева
+// получает родителя прежнего, а ссылку самого родителя правит вызывающий
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::rotateLeft(Node* x) {
     Node* y = x->right;
     x->right = y->left;
+    if (y->left)
+        y->left->parent = x;
     y->left = x;
+    y->parent = x->parent;
+    x->parent = y;
 
-    updateHeight(x);
-    updateHeight(y);
+    updateNode(x);
+    updateNode(y);
 
-    qDebug().noquote() << "[rotateLeft] Поворот влево вокруг ключа:"
-                       << QVariant::fromValue(x->key).toString();
+    TRACE(Trace, Tree, "[rotateLeft] Поворот влево вокруг ключа: %1", x->key);
 
     return y;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::rotateRight(Node* y) {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::rotateRight(Node* y) {
     Node* x = y->left;
     y->left = x->right;
+    if (x->right)
+        x->right->parent = y;
     x->right = y;
+    x->parent = y->parent;
+    y->parent = x;
 
-    updateHeight(y);
-    updateHeight(x);
+    updateNode(y);
+    updateNode(x);
 
-    qDebug().noquote() << "[rotateRight] Поворот вправо вокруг ключа:"
-                       << QVariant::fromValue(y->key).toString();
+    TRACE(Trace, Tree, "[rotateRight] Поворот вправо вокруг ключа: %1", y->key);
 
     return x;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::balance(Node* node) {
-    updateHeight(node);
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::balance(Node* node) {
+    updateNode(node);
     int bf = getBalance(node);
 
     if (bf > 1) {
-        qDebug().noquote() << "[balance] Левый перекос (bf =" << bf << ") у ключа:"
-                           << QVariant::fromValue(node->key).toString();
+        TRACE(Trace, Tree, "[balance] Левый перекос (bf = %1) у ключа: %2", bf, node->key);
 
         if (getBalance(node->left) < 0) {
-            qDebug().noquote() << "  → двойной поворот (лево-вправо)";
+            TRACE(Trace, Tree, "  → двойной поворот (лево-вправо)");
             node->left = rotateLeft(node->left);
         } else {
-            qDebug().noquote() << "  → одинарный поворот вправо";
+            TRACE(Trace, Tree, "  → одинарный поворот вправо");
         }
         return rotateRight(node);
     }
 
     if (bf < -1) {
-        qDebug().noquote() << "[balance] Правый перекос (bf =" << bf << ") у ключа:"
-                           << QVariant::fromValue(node->key).toString();
+        TRACE(Trace, Tree, "[balance] Правый перекос (bf = %1) у ключа: %2", bf, node->key);
 
         if (getBalance(node->right) > 0) {
-            qDebug().noquote() << "  → двойной поворот (право-влево)";
+            TRACE(Trace, Tree, "  → двойной поворот (право-влево)");
             node->right = rotateRight(node->right);
         } else {
-            qDebug().noquote() << "  → одинарный поворот влево";
+            TRACE(Trace, Tree, "  → одинарный поворот влево");
         }
         return rotateLeft(node);
     }
@@ -194,419 +421,717 @@ AVLTree<KeyType, T, ArrayType>::balance(Node* node) {
     return node;
 }
 
-// РЕАЛИЗАЦИЯ МЕТОДОВ ВСТАВКИ
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::insert(Node* node, const KeyType& key, std::size_t index) {
-    if (!node) {
-        qDebug().noquote() << "[insert] Создан новый узел с ключом:"
-                           << QVariant::fromValue(key).toString()
-                           << ", индекс в массиве:" << index;
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::replaceChild(Node* parent, Node* oldChild, Node* newChild) {
+    if (!parent)
+        root = newChild;
+    else if (parent->left == oldChild)
+        parent->left = newChild;
+    else
+        parent->right = newChild;
+
+    if (newChild)
+        newChild->parent = parent;
+}
 
-        Node* newNode = new Node(key);
-        newNode->indexList.add(index);
-        return newNode;
-    }
+// Балансировка от узла к корню. Подъём прекращается, как только высота
+// очередного поддерева не изменилась: выше него ничего не поменялось
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::rebalanceUp(Node* node) {
+    while (node) {
+        Node* parent = node->parent;
+        int oldHeight = node->height;
 
-    if (key < node->key) {
-        qDebug().noquote() << "[insert] Переход влево от ключа:"
-                           << QVariant::fromValue(node->key).toString();
-        node->left = insert(node->left, key, index);
-    } else if (key > node->key) {
-        qDebug().noquote() << "[insert] Переход вправо от ключа:"
-                           << QVariant::fromValue(node->key).toString();
-        node->right = insert(node->right, key, index);
-    } else {
-        qDebug().noquote() << "[insert] Добавление индекса к существующему ключу:"
-                           << QVariant::fromValue(key).toString()
-                           << ", индекс:" << index;
-        node->indexList.add(index);
+        Node* subtree = balance(node);
+        if (subtree != node)
+            replaceChild(parent, node, subtree);
+
+        if (subtree->height == oldHeight) {
+            updateCountsUp(parent);
+            break;
+        }
+        node = parent;
     }
+}
+
+// РЕАЛИЗАЦИЯ МЕТОДОВ ВСТАВКИ
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::addEntry(Node* node, std::size_t index) {
+    if (index >= entryOf.size())
+        entryOf.resize(index + 1, EntryRef{nullptr, 0});
+    entryOf[index] = {node, static_cast<std::uint32_t>(node->indexList.size())};
+
+    std::size_t capacity = node->indexList.capacity();
+    node->indexList.push_back(index, lists);
+    if (node->indexList.capacity() != capacity)
+        TRACE(Trace, List, "Список индексов ключа %1 вынесен из узла, ёмкость %2", node->key, node->indexList.capacity());
+}
 
-    return balance(node);
+// Удаляет индекс из списка узла; у сдвинутых следом индексов правятся позиции
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::eraseEntry(Node* node, std::size_t pos) {
+    node->indexList.erase(pos);
+    for (std::size_t i = pos; i < node->indexList.size(); ++i)
+        entryOf[node->indexList[i]].pos = static_cast<std::uint32_t>(i);
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::insert(const KeyType& key, const T& value, ArrayType& array) {
-    qDebug().noquote() << "[insert] Попытка добавить элемент с ключом:"
-                       << QVariant::fromValue(key).toString();
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::insert(const KeyType& key, const T& value, ArrayType& array) {
+    TRACE(Debug, Tree, "[insert] Попытка добавить элемент с ключом: %1", key);
 
     if (!array.Add(value)) {
-        qDebug().noquote() << "→ Массив переполнен, вставка невозможна";
+        TRACE(Error, Tree, "→ Массив переполнен, вставка невозможна");
         return false;
     }
 
     std::size_t index = array.Size() - 1;
-    qDebug().noquote() << "→ Добавлено в массив, индекс:" << index;
+    TRACE(Trace, Tree, "→ Добавлено в массив, индекс: %1", index);
 
-    root = insert(root, key, index);
-    return true;
+    return insertIndex(key, index);
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::insertIndex(const KeyType& key, std::size_t index) {
-    qDebug().noquote() << "[insertIndex] Вставка индекса:" << index
-                       << "в дерево с ключом:" << QVariant::fromValue(key).toString();
+// Один спуск: либо находим узел с ключом и дописываем индекс,
+// либо подвешиваем новый лист и балансируем путь к корню
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::insertIndex(const KeyType& key, std::size_t index) {
+    TRACE(Debug, Tree, "[insertIndex] Вставка индекса: %1 в дерево с ключом: %2", index, key);
+
+    Node* parent = nullptr;
+    Node* node = root;
+    while (node) {
+        if (key < node->key) {
+            TRACE(Trace, Tree, "[insert] Переход влево от ключа: %1", node->key);
+            parent = node;
+            node = node->left;
+        } else if (key > node->key) {
+            TRACE(Trace, Tree, "[insert] Переход вправо от ключа: %1", node->key);
+            parent = node;
+            node = node->right;
+        } else {
+            TRACE(Trace, Tree, "[insert] Добавление индекса к существующему ключу: %1, индекс: %2", key, index);
+            addEntry(node, index);
+            updateCountsUp(node);
+            return true;
+        }
+    }
+
+    TRACE(Debug, Tree, "[insert] Создан новый узел с ключом: %1, индекс в массиве: %2", key, index);
+
+    Node* newNode = nodes.create(key);
+    newNode->parent = parent;
+    if (!parent)
+        root = newNode;
+    else if (key < parent->key)
+        parent->left = newNode;
+    else
+        parent->right = newNode;
+    addEntry(newNode, index);
+    updateNode(newNode);
 
-    root = insert(root, key, index);
+    rebalanceUp(parent);
     return true;
 }
 
-// РЕАЛИЗАЦИЯ МЕТОДОВ ПОИСКА
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::findNode(Node* node, const KeyType& key) const {
-    if (!node) {
-        qDebug().noquote() << "[findNode] Ключ" << QVariant::fromValue(key).toString() << "не найден (nullptr)";
-        return nullptr;
-    }
+// Пакетное построение: узлы создаются по одному на ключ в порядке
+// возрастания (в арене они ложатся подряд), затем из них собирается
+// идеально сбалансированное дерево — середина отрезка становится корнем.
+// Ни спусков, ни поворотов; глубина рекурсии сборки — log2 числа ключей.
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::buildFromSorted(
+    const std::vector<std::pair<KeyType, std::size_t>>& entries)
+{
+    TRACE(Info, Tree, "[buildFromSorted] Построение из %1 записей", entries.size());
 
-    if (key == node->key) {
-        qDebug().noquote() << "[findNode] Найден узел с ключом:" << QVariant::fromValue(key).toString();
-        return node;
+    for (std::size_t i = 1; i < entries.size(); ++i)
+        if (entries[i].first < entries[i - 1].first)
+            throw std::invalid_argument("buildFromSorted: записи не упорядочены по ключу");
+
+    clear();
+
+    std::vector<Node*> sorted;
+    for (const auto& [key, index] : entries) {
+        if (sorted.empty() || sorted.back()->key < key)
+            sorted.push_back(nodes.create(key));
+        addEntry(sorted.back(), index);
     }
 
-    qDebug().noquote() << "[findNode] Ищу" << QVariant::fromValue(key).toString()
-                       << (key < node->key ? "влево от" : "вправо от")
-                       << QVariant::fromValue(node->key).toString();
+    root = linkBalanced(sorted.data(), sorted.size(), nullptr);
 
-    return key < node->key ? findNode(node->left, key) : findNode(node->right, key);
+    TRACE(Info, Tree, "[buildFromSorted] Узлов: %1, высота: %2", sorted.size(), getHeight(root));
 }
 
-// РЕАЛИЗАЦИЯ МЕТОДОВ УДАЛЕНИЯ
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::remove(const KeyType& key, const T& value, ArrayType& array) {
-    qDebug().noquote() << QString("=== УДАЛЕНИЕ AVL: ключ = \"%1\" ===").arg(QVariant::fromValue(key).toString());
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::linkBalanced(Node* const* sorted, std::size_t count, Node* parent) {
+    if (count == 0)
+        return nullptr;
 
-    Node* node = findNode(root, key);
-    if (!node) {
-        qDebug().noquote() << "→ узел с таким ключом не найден";
-        return false;
+    std::size_t mid = count / 2;
+    Node* node = sorted[mid];
+    node->parent = parent;
+    node->left = linkBalanced(sorted, mid, node);
+    node->right = linkBalanced(sorted + mid + 1, count - mid - 1, node);
+    updateNode(node);
+    return node;
+}
+
+// РЕАЛИЗАЦИЯ МЕТОДОВ ПОИСКА
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::findNode(const KeyType& key) const {
+    Node* node = root;
+    while (node) {
+        if (key < node->key) {
+            TRACE(Trace, Tree, "[findNode] Ищу %1 влево от %2", key, node->key);
+            node = node->left;
+        } else if (key > node->key) {
+            TRACE(Trace, Tree, "[findNode] Ищу %1 вправо от %2", key, node->key);
+            node = node->right;
+        } else {
+            TRACE(Trace, Tree, "[findNode] Найден узел с ключом: %1", key);
+            return node;
+        }
     }
 
-    lNode* current = node->indexList.getHead();
-    int indexInList = 0;
-    std::size_t arrayIndex = 0;
-    bool found = false;
-
-    do {
-        if (!current) break;
-        const T& entry = array[current->arrayIndex];
-        if (entry == value) {
-            arrayIndex = current->arrayIndex;
-            found = true;
-            break;
+    TRACE(Trace, Tree, "[findNode] Ключ %1 не найден (nullptr)", key);
+    return nullptr;
+}
+
+// Спуск запоминает последний узел, где пришлось свернуть влево: это
+// наименьший ключ, не меньше искомого
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::const_iterator
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::lowerBound(const KeyType& key) const {
+    const Node* bound = nullptr;
+    const Node* node = root;
+    while (node) {
+        if (node->key < key) {
+            node = node->right;
+        } else {
+            bound = node;
+            node = node->left;
         }
-        current = current->next;
-        ++indexInList;
-    } while (current != node->indexList.getHead());
+    }
 
-    if (!found) {
-        qDebug().noquote() << "→ элемент не найден в списке индексов";
-        return false;
+    TRACE(Trace, Tree, "[lowerBound] Ключ %1, граница найдена: %2", key, bound != nullptr);
+    return const_iterator(bound, this);
+}
+
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::const_iterator
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::upperBound(const KeyType& key) const {
+    const Node* bound = nullptr;
+    const Node* node = root;
+    while (node) {
+        if (key < node->key) {
+            bound = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
     }
 
-    qDebug().noquote() << QString("→ удаление по индексу %1 из массива").arg(arrayIndex);
-    array.Remove(arrayIndex, *this);
+    TRACE(Trace, Tree, "[upperBound] Ключ %1, граница найдена: %2", key, bound != nullptr);
+    return const_iterator(bound, this);
+}
 
-    qDebug().noquote() << QString("→ удаление из списка узла, позиция в списке = %1").arg(indexInList);
-    node->indexList.removeAt(indexInList);
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Range
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::range(const KeyType& from, const KeyType& to) const {
+    if (to < from)
+        return Range{end(), end()};
+    return Range{lowerBound(from), upperBound(to)};
+}
 
-    if (node->indexList.isEmpty()) {
-        qDebug().noquote() << "→ список индексов пуст — удаляем узел из дерева";
-        root = removeNode(root, key);
-    }
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::minNode(Node* node) {
+    if (node)
+        while (node->left)
+            node = node->left;
+    return node;
+}
 
-    return true;
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::maxNode(Node* node) {
+    if (node)
+        while (node->right)
+            node = node->right;
+    return node;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::removeNode(Node* node, const KeyType& key) {
-    if (!node) return nullptr;
+// Следующий по ключу узел: наименьший в правом поддереве, иначе первый
+// предок, в левом поддереве которого мы находимся
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+const typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::successor(const Node* node) {
+    if (node->right)
+        return minNode(node->right);
+
+    const Node* parent = node->parent;
+    while (parent && node == parent->right) {
+        node = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
 
-    if (key < node->key) {
-        node->left = removeNode(node->left, key);
-    } else if (key > node->key) {
-        node->right = removeNode(node->right, key);
-    } else {
-        qDebug().noquote() << QString("→ удаляем узел с ключом: %1").arg(QVariant::fromValue(key).toString());
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+const typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::predecessor(const Node* node) {
+    if (node->left)
+        return maxNode(node->left);
 
-        if (!node->left) {
-            Node* right = node->right;
-            qDebug().noquote() << "→ нет левого поддерева — возвращаем правого потомка";
-            delete node;
-            return right;
-        }
-        else if (!node->right) {
-            Node* left = node->left;
-            qDebug().noquote() << "→ нет правого поддерева — возвращаем левого потомка";
-            delete node;
-            return left;
-        } else {
-            qDebug().noquote() << "→ оба поддерева существуют — ищем наименьший в правом поддереве";
-            Node* minRight = node->right;
-            while (minRight->left)
-                minRight = minRight->left;
+    const Node* parent = node->parent;
+    while (parent && node == parent->left) {
+        node = parent;
+        parent = parent->parent;
+    }
+    return parent;
+}
 
-            qDebug().noquote() << QString("→ найден наименьший в правом поддереве: %1").arg(QVariant::fromValue(minRight->key).toString());
+// РЕАЛИЗАЦИЯ МЕТОДОВ УДАЛЕНИЯ
+// Удаляет узел из дерева и возвращает узел, с которого начинается
+// балансировка (nullptr — удалён корень без второго поддерева)
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::unlinkNode(Node* node) {
+    TRACE(Debug, Tree, "→ удаляем узел с ключом: %1", node->key);
+
+    Node* parent = node->parent;
+
+    if (!node->left || !node->right) {
+        Node* child = node->left ? node->left : node->right;
+        TRACE(Debug, Tree, "→ не больше одного поддерева — поднимаем потомка");
+        replaceChild(parent, node, child);
+        node->indexList.release(lists);
+        nodes.destroy(node);
+        return parent;
+    }
 
-            node->key = minRight->key;
-            node->indexList = minRight->indexList;
-            node->right = removeNode(node->right, minRight->key);
-        }
+    TRACE(Debug, Tree, "→ оба поддерева существуют — ищем наименьший в правом поддереве");
+    Node* minRight = minNode(node->right);
+
+    TRACE(Debug, Tree, "→ найден наименьший в правом поддереве: %1", minRight->key);
+
+    // Узел-преемник переставляется целиком: его список индексов
+    // не копируется, и обратные ссылки на элементы списка остаются верными
+    Node* start = minRight;
+    if (minRight->parent != node) {
+        start = minRight->parent;
+        start->left = minRight->right;
+        if (minRight->right)
+            minRight->right->parent = start;
+        minRight->right = node->right;
+        node->right->parent = minRight;
     }
 
-    return balance(node);
-}
+    minRight->left = node->left;
+    node->left->parent = minRight;
+    minRight->height = node->height;
+    replaceChild(parent, node, minRight);
 
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::removeAllByKey(const KeyType& key) {
-    qDebug().noquote() << QString("=== УДАЛЕНИЕ ВСЕХ ПО КЛЮЧУ: %1 ===")
-                              .arg(QVariant::fromValue(key).toString());
+    node->indexList.release(lists);
+    nodes.destroy(node);
+    return start;
+}
 
-    Node* node = findNode(root, key);
-    if (!node) {
-        qDebug().noquote() << "→ узел с таким ключом не найден";
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::removeIndex(std::size_t index) {
+    EntryRef entry = index < entryOf.size() ? entryOf[index] : EntryRef{nullptr, 0};
+    if (!entry.node) {
+        TRACE(Debug, Tree, "[removeIndex] индекс %1 в дереве не найден", index);
         return false;
     }
 
-    root = removeNode(root, key);
-    qDebug().noquote() << "→ узел удалён из дерева";
+    Node* node = entry.node;
+    TRACE(Debug, Tree, "[removeIndex] индекс %1, ключ %2", index, node->key);
+
+    eraseEntry(node, entry.pos);
+    entryOf[index] = {nullptr, 0};
+
+    if (node->indexList.empty())
+        rebalanceUp(unlinkNode(node));
+    else
+        updateCountsUp(node);
     return true;
 }
 
 // РЕАЛИЗАЦИЯ ВСПОМОГАТЕЛЬНЫХ МЕТОДОВ
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::fixIndex(std::size_t oldIdx, std::size_t newIdx) {
-    qDebug().noquote() << QString("AVL fixIndex: %1 → %2").arg(oldIdx).arg(newIdx);
-
-    std::function<void(Node*)> fix = [&](Node* node) {
-        if (!node) return;
-
-        lNode* current = node->indexList.getHead();
-        if (current) {
-            do {
-                if (current->arrayIndex == oldIdx) {
-                    current->arrayIndex = newIdx;
-                    qDebug().noquote() << QString("  обновлён индекс в узле key=%1")
-                                              .arg(QVariant::fromValue(node->key).toString());
-                    break; // если предполагается одно вхождение
-                }
-                current = current->next;
-            } while (current != node->indexList.getHead());
-        }
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::fixIndex(std::size_t oldIdx, std::size_t newIdx) {
+    TRACE(Trace, Tree, "AVL fixIndex: %1 → %2", oldIdx, newIdx);
 
-        fix(node->left);
-        fix(node->right);
-    };
+    EntryRef entry = oldIdx < entryOf.size() ? entryOf[oldIdx] : EntryRef{nullptr, 0};
+    if (!entry.node) {
+        TRACE(Debug, Tree, "  индекс %1 в дереве не найден", oldIdx);
+        return;
+    }
 
-    fix(root);
+    entry.node->indexList[entry.pos] = newIdx;
+    if (newIdx >= entryOf.size())
+        entryOf.resize(newIdx + 1, EntryRef{nullptr, 0});
+    entryOf[newIdx] = entry;
+    entryOf[oldIdx] = {nullptr, 0};
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::Node*
-AVLTree<KeyType, T, ArrayType>::getRoot() const {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::Node*
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getRoot() const {
     if (root) {
-        qDebug().noquote() << "[getRoot] Корень дерева — ключ:"
-                           << QVariant::fromValue(root->key).toString();
+        TRACE(Debug, Tree, "[getRoot] Корень дерева — ключ: %1", root->key);
     } else {
-        qDebug().noquote() << "[getRoot] Дерево пусто (root == nullptr)";
+        TRACE(Debug, Tree, "[getRoot] Дерево пусто (root == nullptr)");
     }
     return root;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverse(
-    std::function<void(const T&, const KeyType&)> callback,
-    const ArrayType& array) const
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::isEmpty() const {
+    return root == nullptr;
+}
+
+// РЕАЛИЗАЦИЯ ОБХОДОВ
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Visitor>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::traverse(Visitor&& callback, const ArrayType& array) const
 {
-    qDebug().noquote() << "[traverse] Начат обход дерева справа налево";
-    traverse(root, callback, array);
+    TRACE(Trace, Tree, "[traverse] Начат обход дерева справа налево");
+
+    for (auto it = rbegin(); it != rend(); ++it) {
+        TRACE(Trace, Tree, "[traverse] Обработка узла с ключом: %1", it->key);
+
+        for (std::size_t idx : it->indexList) {
+            TRACE(Trace, Tree, "  → Вызов callback для индекса %1", idx);
+            callback(array[idx], it->key);
+        }
+    }
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverse(
-    Node* node,
-    std::function<void(const T&, const KeyType&)> callback,
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Filter, typename Accept>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::traverseFiltered(
+    Filter&& filter,
+    Accept&& onAccept,
     const ArrayType& array) const
 {
-    if (!node) return;
-
-    // ОБХОД СПРАВА НАЛЕВО: сначала правое поддерево
-    traverse(node->right, callback, array);
-
-    qDebug().noquote() << QString("[traverse] Обработка узла с ключом: %1")
-                              .arg(QVariant::fromValue(node->key).toString());
-
-    lNode* current = node->indexList.getHead();
-    int count = 0;
-    if (current) {
-        do {
-            std::size_t idx = current->arrayIndex;
-            qDebug().noquote() << QString("  → Вызов callback для индекса %1").arg(idx);
-            callback(array[idx], node->key);
-            current = current->next;
-            ++count;
-        } while (current != node->indexList.getHead());
+    TRACE(Trace, Tree, "[traverseFiltered] Начат обход с фильтрацией (справа налево)");
+
+    for (auto it = rbegin(); it != rend(); ++it) {
+        TRACE(Trace, Tree, "[traverseFiltered] Узел с ключом: %1", it->key);
+
+        int passed = 0;
+        for (std::size_t idx : it->indexList) {
+            const T& item = array[idx];
+            if (filter(item)) {
+                ++passed;
+                TRACE(Trace, Tree, "  → элемент по индексу %1 прошёл фильтр", idx);
+                onAccept(item);
+            } else {
+                TRACE(Trace, Tree, "  → элемент по индексу %1 не прошёл фильтр", idx);
+            }
+        }
+
+        if (passed == 0)
+            TRACE(Trace, Tree, "  → ничего не подошло по фильтру");
     }
+}
+
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Visitor>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::traverseIndex(Visitor&& callback) const
+{
+    TRACE(Trace, Tree, "[traverseIndex] Начат обход индексов (справа налево)");
 
-    if (count == 0) {
-        qDebug().noquote() << "  → Список индексов пуст";
+    for (auto it = rbegin(); it != rend(); ++it) {
+        TRACE(Trace, Tree, "[traverseIndex] Узел с ключом: %1", it->key);
+
+        for (std::size_t idx : it->indexList) {
+            TRACE(Trace, Tree, "  → индекс: %1", idx);
+            callback(idx, it->key);
+        }
+    }
+}
+
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Visitor>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::traverseByKey(const KeyType& key, Visitor&& callback) const {
+    Node* node = findNode(key);
+    if (!node) {
+        TRACE(Trace, Tree, "[traverseByKey] Ключ %1 не найден", key);
+        return;
     }
 
-    // Затем левое поддерево
-    traverse(node->left, callback, array);
+    for (std::size_t idx : node->indexList)
+        callback(idx);
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverseFiltered(
-    std::function<bool(const T&)> filter,
-    std::function<void(const T&)> onAccept,
-    const ArrayType& array) const
-{
-    qDebug().noquote() << "[traverseFiltered] Начат обход с фильтрацией (справа налево)";
-    traverseFiltered(root, filter, onAccept, array);
+// В отличие от полных обходов идёт по возрастанию ключа: так отчёты
+// за период выводятся в хронологическом порядке
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Visitor>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::traverseRange(const KeyType& from, const KeyType& to,
+                                                            Visitor&& callback) const {
+    TRACE(Trace, Tree, "[traverseRange] Обход ключей от %1 до %2", from, to);
+
+    for (const Node& node : range(from, to)) {
+        for (std::size_t idx : node.indexList)
+            callback(idx, node.key);
+    }
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverseFiltered(
-    Node* node,
-    std::function<bool(const T&)> filter,
-    std::function<void(const T&)> onAccept,
-    const ArrayType& array) const
-{
-    if (!node) return;
+// РЕАЛИЗАЦИЯ ПАРАЛЛЕЛЬНЫХ ОБХОДОВ
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Acc, typename Visitor, typename Merge>
+Acc AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::parallelTraverse(Visitor&& visitor, Merge&& merge,
+                                                                MergeOrder order, int splitDepth) const {
+    return runParallel<Acc>(nullptr, nullptr, nullptr, visitor, merge, order, splitDepth);
+}
 
-    // ОБХОД СПРАВА НАЛЕВО
-    traverseFiltered(node->right, filter, onAccept, array);
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Acc, typename Visitor, typename Merge>
+Acc AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::parallelTraverseRange(const KeyType& from, const KeyType& to,
+                                                                     Visitor&& visitor, Merge&& merge,
+                                                                     MergeOrder order, int splitDepth) const {
+    if (to < from)
+        return Acc{};
+    return runParallel<Acc>(&from, &to, nullptr, visitor, merge, order, splitDepth);
+}
 
-    qDebug().noquote() << QString("[traverseFiltered] Узел с ключом: %1")
-                              .arg(QVariant::fromValue(node->key).toString());
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Acc, typename Visitor, typename Merge>
+Acc AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::parallelTraverseRange(const KeyType& from, const KeyType& to,
+                                                                     Acc init, Visitor&& visitor, Merge&& merge,
+                                                                     MergeOrder order, int splitDepth) const {
+    if (to < from)
+        return init;
+    return runParallel<Acc>(&from, &to, &init, visitor, merge, order, splitDepth);
+}
 
-    lNode* current = node->indexList.getHead();
-    int passed = 0;
-    if (current) {
-        do {
-            const T& item = array[current->arrayIndex];
-            if (filter(item)) {
-                ++passed;
-                qDebug().noquote() << QString("  → элемент по индексу %1 прошёл фильтр").arg(current->arrayIndex);
-                onAccept(item);
+// Части собираются в порядке ключей. Поддеревья целиком вне отрезка
+// [from, to] отбрасываются, спуск мимо них глубину разреза не расходует;
+// рекурсия не глубже высоты дерева
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+void AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::collectSegments(const Node* node, int depth, int splitDepth,
+                                                               const KeyType* from, const KeyType* to,
+                                                               std::vector<Segment>& out) const {
+    if (!node)
+        return;
+
+    if (from && node->key < *from) {
+        collectSegments(node->right, depth, splitDepth, from, to, out);
+        return;
+    }
+    if (to && *to < node->key) {
+        collectSegments(node->left, depth, splitDepth, from, to, out);
+        return;
+    }
+
+    if (depth == splitDepth) {
+        out.push_back({node, true});
+        return;
+    }
+
+    collectSegments(node->left, depth + 1, splitDepth, from, to, out);
+    out.push_back({node, false});
+    collectSegments(node->right, depth + 1, splitDepth, from, to, out);
+}
+
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+template<typename Acc, typename Visitor, typename Merge>
+Acc AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::runParallel(const KeyType* from, const KeyType* to, Acc* init,
+                                                           Visitor& visitor, Merge& merge,
+                                                           MergeOrder order, int splitDepth) const {
+    // Малое дерево обходится в вызывающем потоке, пул даже не создаётся
+    unsigned threads = getHeight(root) < ParallelMinHeight
+                           ? 1u
+                           : static_cast<unsigned>(WorkerPool::instance().threadCount());
+    // По умолчанию частей примерно вчетверо больше потоков: быстрые
+    // потоки добирают части медленных
+    if (splitDepth <= 0)
+        splitDepth = threads == 1 ? 0 : static_cast<int>(std::bit_width(threads * 4u)) - 1;
+
+    std::vector<Segment> segments;
+    collectSegments(root, 0, splitDepth, from, to, segments);
+    if (segments.empty())
+        return init ? std::move(*init) : Acc{};
+
+    // Узлы поддерева по возрастанию ключа, начиная с первого не меньше from
+    auto visitSegment = [&](const Segment& segment, Acc& acc) {
+        if (!segment.whole) {
+            visitor(*segment.node, acc);
+            return;
+        }
+
+        const Node* last = segment.node;
+        while (last->right)
+            last = last->right;
+        const Node* stop = successor(last);
+
+        const Node* node = nullptr;
+        for (const Node* probe = segment.node; probe;) {
+            if (from && probe->key < *from) {
+                probe = probe->right;
             } else {
-                qDebug().noquote() << QString("  → элемент по индексу %1 не прошёл фильтр").arg(current->arrayIndex);
+                node = probe;
+                probe = probe->left;
             }
-            current = current->next;
-        } while (current != node->indexList.getHead());
-    }
+        }
+
+        for (; node && node != stop && !(to && *to < node->key); node = successor(node))
+            visitor(*node, acc);
+    };
+
+    const std::size_t workers = std::min<std::size_t>(threads, segments.size());
+    std::vector<Acc> parts(order == MergeOrder::Ordered ? segments.size() : workers);
+
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto work = [&](std::size_t worker) {
+        try {
+            for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < segments.size();
+                 i = next.fetch_add(1, std::memory_order_relaxed))
+                visitSegment(segments[i], parts[order == MergeOrder::Ordered ? i : worker]);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure)
+                failure = std::current_exception();
+        }
+    };
+
+    // Вызывающий поток — рабочий 0, остальных даёт общий пул
+    if (workers > 1)
+        WorkerPool::instance().run(workers, work);
+    else
+        work(0);
 
-    if (passed == 0)
-        qDebug().noquote() << "  → ничего не подошло по фильтру";
+    if (failure)
+        std::rethrow_exception(failure);
 
-    traverseFiltered(node->left, filter, onAccept, array);
+    TRACE(Debug, Tree, "[parallelTraverse] Частей: %1, потоков: %2", segments.size(), workers);
+
+    // Без начального аккумулятора итог начинается с первой части
+    Acc result = init ? std::move(*init) : std::move(parts[0]);
+    for (std::size_t i = init ? 0 : 1; i < parts.size(); ++i)
+        merge(result, std::move(parts[i]));
+    return result;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverseIndex(
-    std::function<void(std::size_t, const KeyType&)> callback) const
-{
-    qDebug().noquote() << "[traverseIndex] Начат обход индексов (справа налево)";
-    traverseIndex(root, callback);
+// РЕАЛИЗАЦИЯ ПОРЯДКОВЫХ ЗАПРОСОВ
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::size_t AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::size() const requires OrderStatistics {
+    return elementsOf(root);
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverseIndex(
-    Node* node,
-    std::function<void(std::size_t, const KeyType&)> callback) const
-{
-    if (!node) return;
-
-    // ОБХОД СПРАВА НАЛЕВО
-    traverseIndex(node->right, callback);
-
-    qDebug().noquote() << QString("[traverseIndex] Узел с ключом: %1")
-                              .arg(QVariant::fromValue(node->key).toString());
-
-    lNode* current = node->indexList.getHead();
-    int count = 0;
-    if (current) {
-        do {
-            qDebug().noquote() << QString("  → индекс: %1").arg(current->arrayIndex);
-            callback(current->arrayIndex, node->key);
-            current = current->next;
-            ++count;
-        } while (current != node->indexList.getHead());
+// Один спуск: при каждом шаге вправо левое поддерево и сам узел
+// целиком лежат ниже границы
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::size_t AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::countBelow(const KeyType& key, bool inclusive) const {
+    std::size_t count = 0;
+    const Node* node = root;
+    while (node) {
+        bool below = inclusive ? !(key < node->key) : node->key < key;
+        if (below) {
+            count += elementsOf(node->left) + node->indexList.size();
+            node = node->right;
+        } else {
+            node = node->left;
+        }
     }
+    return count;
+}
+
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::size_t AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::rank(const KeyType& key) const requires OrderStatistics {
+    std::size_t result = countBelow(key, false);
+    TRACE(Trace, Tree, "[rank] Ключ %1 → %2", key, result);
+    return result;
+}
 
-    if (count == 0) {
-        qDebug().noquote() << "  → список индексов пуст";
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::pair<typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::const_iterator, std::size_t>
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::select(std::size_t k) const requires OrderStatistics {
+    TRACE(Trace, Tree, "[select] Запись номер %1", k);
+
+    const Node* node = root;
+    while (node) {
+        std::size_t left = elementsOf(node->left);
+        if (k < left) {
+            node = node->left;
+        } else if (k < left + node->indexList.size()) {
+            return {const_iterator(node, this), k - left};
+        } else {
+            k -= left + node->indexList.size();
+            node = node->right;
+        }
     }
+    return {end(), 0};
+}
 
-    traverseIndex(node->left, callback);
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::size_t AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::countInRange(const KeyType& from, const KeyType& to) const requires OrderStatistics {
+    if (to < from)
+        return 0;
+    return countBelow(to, true) - countBelow(from, false);
 }
 
 // РЕАЛИЗАЦИЯ НОВЫХ МЕТОДОВ ДЛЯ РЕФЕРЕНЦИАЛЬНОЙ ЦЕЛОСТНОСТИ
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::keyExists(const KeyType& key) const {
-    qDebug().noquote() << QString("[keyExists] Проверка ключа: %1")
-                              .arg(QVariant::fromValue(key).toString());
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::keyExists(const KeyType& key) const {
+    TRACE(Debug, Tree, "[keyExists] Проверка ключа: %1", key);
 
-    Node* node = findNode(root, key);
-    bool exists = (node != nullptr && !node->indexList.isEmpty());
+    Node* node = findNode(key);
+    bool exists = (node != nullptr && !node->indexList.empty());
 
-    qDebug().noquote() << QString("→ Результат: %1").arg(exists ? "НАЙДЕН" : "НЕ НАЙДЕН");
+    TRACE(Debug, Tree, "→ Результат: %1", exists);
     return exists;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-int AVLTree<KeyType, T, ArrayType>::getCountForKey(const KeyType& key) const {
-    Node* node = findNode(root, key);
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+int AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getCountForKey(const KeyType& key) const {
+    Node* node = findNode(key);
     if (!node) return 0;
 
-    return node->indexList.getSize();
+    return static_cast<int>(node->indexList.size());
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-std::vector<KeyType> AVLTree<KeyType, T, ArrayType>::getAllKeys() const {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+std::vector<KeyType> AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getAllKeys() const {
     std::vector<KeyType> keys;
 
-    std::function<void(Node*)> collectKeys = [&](Node* node) {
-        if (!node) return;
-
-        collectKeys(node->left);
-        if (!node->indexList.isEmpty()) {
-            keys.push_back(node->key);
+    for (const Node& node : *this) {
+        if (!node.indexList.empty()) {
+            keys.push_back(node.key);
         }
-        collectKeys(node->right);
-    };
-
-    collectKeys(root);
+    }
 
     qDebug().noquote() << QString("Собрано уникальных ключей: %1").arg(keys.size());
     return keys;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-typename AVLTree<KeyType, T, ArrayType>::TreeStatistics
-AVLTree<KeyType, T, ArrayType>::getStatistics() const {
-    TreeStatistics stats = {0, 0, 0, 0};
-
-    std::function<int(Node*, int)> calculateStats = [&](Node* node, int depth) -> int {
-        if (!node) return depth - 1;
-
-        stats.totalNodes++;
-        stats.totalElements += node->indexList.getSize();
-        if (!node->indexList.isEmpty()) {
-            stats.uniqueKeys++;
-        }
-
-        int leftDepth = calculateStats(node->left, depth + 1);
-        int rightDepth = calculateStats(node->right, depth + 1);
-
-        return std::max(leftDepth, rightDepth);
-    };
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+typename AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::TreeStatistics
+AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::getStatistics() const {
+    // Счётчики независимы от порядка: части копят свои, затем суммируются
+    TreeStatistics stats = parallelTraverse<TreeStatistics>(
+        [](const Node& node, TreeStatistics& part) {
+            part.totalNodes++;
+            part.totalElements += static_cast<int>(node.indexList.size());
+            if (!node.indexList.empty()) {
+                part.uniqueKeys++;
+            }
+        },
+        [](TreeStatistics& into, TreeStatistics&& part) {
+            into.totalNodes += part.totalNodes;
+            into.totalElements += part.totalElements;
+            into.uniqueKeys += part.uniqueKeys;
+        },
+        MergeOrder::Unordered);
 
-    stats.maxDepth = calculateStats(root, 0);
+    // Глубина самого глубокого узла (у корня 0) — высота корня минус один
+    stats.maxDepth = getHeight(root) - 1;
 
     qDebug().noquote() << QString("Статистика дерева: узлов=%1, элементов=%2, глубина=%3, ключей=%4")
                               .arg(stats.totalNodes)
@@ -617,53 +1142,52 @@ AVLTree<KeyType, T, ArrayType>::getStatistics() const {
     return stats;
 }
 
-template<typename KeyType, typename T, typename ArrayType>
-bool AVLTree<KeyType, T, ArrayType>::validateIntegrity(const ArrayType& array) const {
-    bool isValid = true;
-
-    std::function<void(Node*)> validate = [&](Node* node) {
-        if (!node) return;
-
-        // Проверяем, что все индексы в списке действительны
-        lNode* current = node->indexList.getHead();
-        if (current) {
-            do {
-                if (current->arrayIndex >= array.Size()) {
+template<typename KeyType, typename T, typename ArrayType, template<typename> class Allocator, bool OrderStatistics>
+bool AVLTree<KeyType, T, ArrayType, Allocator, OrderStatistics>::validateIntegrity(const ArrayType& array) const {
+    // Узлы проверяются независимо: части считают свои ошибки, затем суммируются
+    std::size_t errors = parallelTraverse<std::size_t>(
+        [this, &array](const Node& node, std::size_t& found) {
+            // Проверяем, что все индексы в списке действительны
+            for (std::size_t idx : node.indexList) {
+                if (idx >= array.Size()) {
                     qDebug().noquote() << QString("ОШИБКА: индекс %1 больше размера массива %2")
-                                              .arg(current->arrayIndex)
+                                              .arg(idx)
                                               .arg(array.Size());
-                    isValid = false;
+                    ++found;
                 }
-                current = current->next;
-            } while (current != node->indexList.getHead());
-        }
+            }
 
-        validate(node->left);
-        validate(node->right);
-    };
+            // Ссылки на родителя и высоты, на которые опираются итеративные операции
+            if ((node.left && node.left->parent != &node) || (node.right && node.right->parent != &node)) {
+                qDebug().noquote() << "ОШИБКА: нарушена ссылка на родителя у узла";
+                ++found;
+            }
+            int leftHeight = getHeight(node.left);
+            int rightHeight = getHeight(node.right);
+            if (node.height != 1 + std::max(leftHeight, rightHeight) || std::abs(leftHeight - rightHeight) > 1) {
+                qDebug().noquote() << QString("ОШИБКА: узел разбалансирован (высоты %1/%2)")
+                                          .arg(leftHeight)
+                                          .arg(rightHeight);
+                ++found;
+            }
 
-    validate(root);
+            if constexpr (OrderStatistics) {
+                std::size_t keys = 1 + (node.left ? node.left->subtreeKeys : 0) + (node.right ? node.right->subtreeKeys : 0);
+                std::size_t elements = node.indexList.size() + elementsOf(node.left) + elementsOf(node.right);
+                if (node.subtreeKeys != keys || node.subtreeElements != elements) {
+                    qDebug().noquote() << "ОШИБКА: неверные счётчики поддерева у узла";
+                    ++found;
+                }
+            }
+        },
+        [](std::size_t& into, std::size_t&& part) { into += part; },
+        MergeOrder::Unordered);
+    bool isValid = errors == 0;
 
     qDebug().noquote() << QString("Проверка целостности: %1")
                               .arg(isValid ? "ПРОЙДЕНА" : "ПРОВАЛЕНА");
     return isValid;
 }
-template<typename KeyType, typename T, typename ArrayType>
-void AVLTree<KeyType, T, ArrayType>::traverseByKey(const KeyType& key, std::function<void(std::size_t)> callback) const {
-    Node* node = findNode(root, key);
-    if (!node) {
-        qDebug().noquote() << QString("[traverseByKey] Ключ %1 не найден").arg(QString::fromStdString(key));
-        return;
-    }
-
-    lNode* current = node->indexList.getHead();
-    if (current) {
-        do {
-            callback(current->arrayIndex);
-            current = current->next;
-        } while (current != node->indexList.getHead());
-    }
-}
 
 
 #endif // AVLTREE3_HPP
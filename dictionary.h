@@ -0,0 +1,61 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include "types.h"
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Словарь строк (интернирование).
+// Каждое уникальное значение хранится один раз, записи держат только его
+// номер DictId, поэтому сравнение значений — сравнение двух целых.
+// Строки лежат в deque: при росте адреса не меняются, и ключи-string_view
+// в индексе остаются действительными.
+class StringDictionary
+{
+public:
+    static constexpr DictId npos = static_cast<DictId>(-1);
+
+    // Номер значения; новое значение добавляется в словарь
+    DictId intern(std::string_view value)
+    {
+        auto it = m_ids.find(value);
+        if (it != m_ids.end())
+            return it->second;
+
+        DictId id = static_cast<DictId>(m_values.size());
+        const std::string &stored = m_values.emplace_back(value);
+        m_ids.emplace(stored, id);
+        return id;
+    }
+
+    // Номер значения или npos, если такого значения нет (словарь не меняется)
+    DictId find(std::string_view value) const
+    {
+        auto it = m_ids.find(value);
+        return it != m_ids.end() ? it->second : npos;
+    }
+
+    // То же для текста из интерфейса: UTF-16 перекодируется в буфер на стеке
+    DictId find(std::u16string_view value) const
+    {
+        char buffer[256];
+        std::size_t length = utf8Into(value, buffer, sizeof(buffer));
+        return length != std::string_view::npos ? find(std::string_view(buffer, length))
+                                                : find(std::string_view(toUtf8(value)));
+    }
+
+    const std::string &operator[](DictId id) const { return m_values[id]; }
+
+    std::size_t size() const { return m_values.size(); }
+
+private:
+    std::deque<std::string> m_values;
+    std::unordered_map<std::string_view, DictId> m_ids;
+};
+
+extern StringDictionary DoctorTypes;
+extern StringDictionary Diagnoses;
+
+#endif // DICTIONARY_H
@@ -0,0 +1,161 @@
+#ifndef FIOINDEX_H
+#define FIOINDEX_H
+
+#include "types.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Вторичный индекс пациентов по ФИО.
+// Ключ — нормализованная строка "фамилия имя отчество": слова разделены
+// одним пробелом, буквы (латиница и кириллица UTF-8) приведены к нижнему
+// регистру. Значение — полисы всех пациентов с таким ФИО.
+// Индекс ведёт хэш-таблица пациентов при вставке и удалении записей.
+class FioIndex
+{
+public:
+    void add(const Patient &patient, PolicyId policy)
+    {
+        m_policies[keyOf(patient)].push_back(policy);
+    }
+
+    void remove(const Patient &patient, PolicyId policy)
+    {
+        auto it = m_policies.find(keyOf(patient));
+        if (it == m_policies.end())
+            return;
+
+        std::vector<PolicyId> &policies = it->second;
+        auto pos = std::find(policies.begin(), policies.end(), policy);
+        if (pos != policies.end())
+        {
+            *pos = policies.back();
+            policies.pop_back();
+        }
+        if (policies.empty())
+            m_policies.erase(it);
+    }
+
+    // Полисы пациентов с ФИО fullName ("Фамилия Имя Отчество" в любом регистре).
+    // Нормализация не удлиняет текст, поэтому обычное ФИО нормализуется
+    // в буфер на стеке и ищется по string_view без выделения памяти
+    const std::vector<PolicyId> &find(std::string_view fullName) const
+    {
+        static const std::vector<PolicyId> none;
+
+        char buffer[256];
+        auto it = fullName.size() <= sizeof(buffer)
+                      ? m_policies.find(std::string_view(buffer, normalizeInto(fullName, buffer)))
+                      : m_policies.find(normalize(fullName));
+        return it != m_policies.end() ? it->second : none;
+    }
+
+    // То же для текста из интерфейса: UTF-16 перекодируется в тот же буфер
+    // на стеке и нормализуется на месте (нормализация пишет не дальше, чем читает)
+    const std::vector<PolicyId> &find(std::u16string_view fullName) const
+    {
+        static const std::vector<PolicyId> none;
+
+        char buffer[256];
+        std::size_t length = utf8Into(fullName, buffer, sizeof(buffer));
+        if (length == std::string_view::npos)
+            return find(toUtf8(fullName));
+
+        auto it = m_policies.find(std::string_view(buffer, normalizeInto(std::string_view(buffer, length), buffer)));
+        return it != m_policies.end() ? it->second : none;
+    }
+
+    std::size_t size() const { return m_policies.size(); }
+
+    static std::string keyOf(const Patient &patient)
+    {
+        std::string key;
+        key.reserve(patient.surname.size() + patient.name.size() + patient.middlename.size() + 2);
+        key += patient.surname;
+        key += ' ';
+        key += patient.name;
+        key += ' ';
+        key += patient.middlename;
+        return normalize(key);
+    }
+
+    static std::string normalize(std::string_view text)
+    {
+        std::string result(text.size(), '\0');
+        result.resize(normalizeInto(text, result.data()));
+        return result;
+    }
+
+    // Пишет нормализованный text в out (не меньше text.size() байт), возвращает длину.
+    // out может совпадать с text.data(): запись не обгоняет чтение
+    static std::size_t normalizeInto(std::string_view text, char *out)
+    {
+        std::size_t length = 0;
+
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+
+            if (c == ' ' || c == '\t')
+            {
+                if (length > 0 && out[length - 1] != ' ')
+                    out[length++] = ' ';
+                continue;
+            }
+
+            if (c >= 'A' && c <= 'Z')
+            {
+                out[length++] = static_cast<char>(c - 'A' + 'a');
+                continue;
+            }
+
+            // Заглавные кириллицы: А..П → а..п, Р..Я → р..я, Ё → ё
+            if (c == 0xD0 && i + 1 < text.size())
+            {
+                unsigned char next = static_cast<unsigned char>(text[i + 1]);
+                if (next >= 0x90 && next <= 0x9F)
+                {
+                    out[length++] = static_cast<char>(0xD0);
+                    out[length++] = static_cast<char>(next + 0x20);
+                    ++i;
+                    continue;
+                }
+                if (next >= 0xA0 && next <= 0xAF)
+                {
+                    out[length++] = static_cast<char>(0xD1);
+                    out[length++] = static_cast<char>(next - 0x20);
+                    ++i;
+                    continue;
+                }
+                if (next == 0x81)
+                {
+                    out[length++] = static_cast<char>(0xD1);
+                    out[length++] = static_cast<char>(0x91);
+                    ++i;
+                    continue;
+                }
+            }
+
+            out[length++] = static_cast<char>(c);
+        }
+
+        if (length > 0 && out[length - 1] == ' ')
+            --length;
+        return length;
+    }
+
+private:
+    // Прозрачный хэш: поиск по string_view без построения std::string
+    struct KeyHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+
+    std::unordered_map<std::string, std::vector<PolicyId>, KeyHash, std::equal_to<>> m_policies;
+};
+
+#endif // FIOINDEX_H
@@ -1,3 +1,5 @@
 #include "globals.h"
-Array<Patient, 1000> PatientArray;
-Array<Appointment, 1000> AppointmentArray;
+PatientStore PatientArray;
+AppointmentStore AppointmentArray;
+StringDictionary DoctorTypes;
+StringDictionary Diagnoses;
@@ -2,6 +2,10 @@
 #define GLOBALS_H
 #include "types.h"
 #include "array.h"
-extern Array<Patient, 1000> PatientArray;
-extern Array<Appointment, 1000> AppointmentArray;
+#include "appointmenttable.h"
+#include "dictionary.h"
+extern PatientStore PatientArray;
+extern AppointmentStore AppointmentArray;
+extern StringDictionary DoctorTypes;
+extern StringDictionary Diagnoses;
 #endif // GLOBALS_H
@@ -7,11 +7,31 @@
 #include <stdexcept>
 #include <QString>
 #include <QDebug>
+#include "tracelog.h"
+#include "fioindex.h"
 #include "types.h"
-#include<sstream>
-#define MAX_SIZE 1000
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <array>
+#define INITIAL_SIZE 1000  // начальная ёмкость по умолчанию
+#define MAX_LOAD_FACTOR 0.7 // порог заполнения, после которого таблица растёт
+#define REHASH_STEP 64     // ячеек старой таблицы, переносимых за одну операцию
 #define DIGITS 4
 
+// Управляющие байты для группового пробирования (1 — включено, 0 — выключено)
+#ifndef HASHTABLE_SIMD_PROBE
+#define HASHTABLE_SIMD_PROBE 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHTABLE_HAVE_SSE2 1
+#endif
+
 inline std::string uint128_to_string(__uint128_t value) {
     if (value == 0) return "0";
     std::string result;
@@ -22,198 +42,794 @@ inline std::string uint128_to_string(__uint128_t value) {
     return result;
 }
 
+// Политики хэширования: функтор (полис, размер таблицы) → начальная позиция.
+
+// Метод середины квадрата: квадрат ключа в десятичной записи, из середины
+// берутся DIGITS цифр. Медленный (строки на каждый вызов), но позиции ячеек
+// совпадают с прежними, по ним сверяются аудиторы.
+struct MidSquareHash
+{
+    std::size_t operator()(PolicyId policy, std::size_t size) const {
+        std::uint64_t key = policy.value;
+        __uint128_t square = static_cast<__uint128_t>(key) * key;
+        std::string squareStr = uint128_to_string(square);
+        std::size_t len = squareStr.length();
+
+        if (len < DIGITS + 2) {
+            std::size_t fallbackHash = key % size;
+            TRACE(Trace, Hash, "Hash (%1): квадрат короткий → %2", key, fallbackHash);
+            return fallbackHash;
+        }
+
+        std::size_t mid = len / 2;
+        std::string midStr = squareStr.substr(mid - DIGITS / 2, DIGITS);
+        std::size_t hashVal = std::stoul(midStr);
+        std::size_t finalHash = hashVal % size;
+
+        TRACE(Trace, Hash, "Hash (%1): середина квадрата = %2, итог = %3", key, hashVal, finalHash);
+
+        return finalHash;
+    }
+};
+
+// Перемешивание 64-битного ключа (финализатор splitmix64) и сведение
+// в [0, size) умножением со сдвигом вместо деления. Без ветвлений и выделений памяти.
+struct FastMixHash
+{
+    std::size_t operator()(PolicyId policy, std::size_t size) const noexcept {
+        std::uint64_t x = policy.value;
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return static_cast<std::size_t>((static_cast<__uint128_t>(x) * size) >> 64);
+    }
+};
+
+// Группа из 16 управляющих байтов таблицы. Байт ячейки — либо Empty (0x80),
+// либо 7 бит хэша ключа, так что пустые ячейки отличаются старшим битом.
+// Сравнение с тегом даёт битовую маску совпадений: одна SSE2-инструкция
+// вместо 16 чтений HashRecord.
+struct ControlGroup
+{
+    static constexpr std::size_t Width = 16;
+    static constexpr std::uint8_t Empty = 0x80;
+
+    const std::uint8_t *bytes;
+
+    std::uint32_t match(std::uint8_t tag) const noexcept {
+#ifdef HASHTABLE_HAVE_SSE2
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < Width; ++i)
+            mask |= std::uint32_t{bytes[i] == tag} << i;
+        return mask;
+#endif
+    }
+
+    std::uint32_t matchEmpty() const noexcept {
+#ifdef HASHTABLE_HAVE_SSE2
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(group));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < Width; ++i)
+            mask |= std::uint32_t{(bytes[i] & Empty) != 0} << i;
+        return mask;
+#endif
+    }
+
+    // 7-битный тег, независимый от номера домашней ячейки
+    static std::uint8_t tagOf(PolicyId policy) noexcept {
+        return static_cast<std::uint8_t>((policy.value * 0x9e3779b97f4a7c15ULL) >> 57);
+    }
+};
+
 struct HashRecord
 {
-    std::size_t key{0};
+    PolicyId key{};
     std::size_t arrayIndex{0};
     Status status{Status::Empty};
+    std::uint32_t probeLength{0}; // расстояние от домашней ячейки (Robin Hood)
 
     std::string getKey() const
     {
-        if (key == 0)
+        if (!key.isValid())
             return "";
 
-        std::string keyStr = std::to_string(key);
-        return keyStr;
+        return key.toString();
     }
 
     std::size_t getArrayIndex() const { return arrayIndex; }
     Status getStatus() const { return status; }
+    std::uint32_t getProbeLength() const { return probeLength; }
+};
+
+// Распределение расстояний пробирования и кластеров одной таблицы.
+// Ведётся на ходу при размещении, вытеснении и обратном сдвиге записей,
+// поэтому статистику можно снять за O(1), без прохода по ячейкам.
+struct ProbeStats
+{
+    static constexpr std::size_t HistogramSize = 32; // последний столбец — "32 и дальше"
+
+    std::size_t count{0};
+    std::size_t totalProbe{0}; // сумма probeLength активных записей
+    std::array<std::size_t, HistogramSize> histogram{};
+
+    // Кластеры — серии занятых ячеек подряд: clusters[L] — число серий длины L
+    std::vector<std::size_t> clusters;
+    std::size_t longestCluster{0};
+    // Сумма groupsBefore(L) по кластерам: из неё средняя длина неуспешного
+    // группового поиска (см. BasicHashTable::unsuccessfulGroups)
+    std::size_t clusterGroups{0};
+
+    static std::size_t bucketOf(std::uint32_t dist) { return std::min<std::size_t>(dist, HistogramSize - 1); }
+
+    void add(std::uint32_t dist)
+    {
+        ++count;
+        totalProbe += dist;
+        ++histogram[bucketOf(dist)];
+    }
+
+    void remove(std::uint32_t dist)
+    {
+        --count;
+        totalProbe -= dist;
+        --histogram[bucketOf(dist)];
+    }
+
+    // Запись сдвинута на ячейку ближе к домашней
+    void shiftBack(std::uint32_t dist)
+    {
+        --totalProbe;
+        --histogram[bucketOf(dist)];
+        ++histogram[bucketOf(dist - 1)];
+    }
+
+    void addCluster(std::size_t length)
+    {
+        if (length == 0)
+            return;
+        if (clusters.size() <= length)
+            clusters.resize(length + 1);
+        ++clusters[length];
+        longestCluster = std::max(longestCluster, length);
+        clusterGroups += groupsBefore(length);
+    }
+
+    void removeCluster(std::size_t length)
+    {
+        if (length == 0)
+            return;
+        --clusters[length];
+        clusterGroups -= groupsBefore(length);
+        while (longestCluster > 0 && clusters[longestCluster] == 0)
+            --longestCluster;
+    }
+
+    // Групповой поиск с ячейки, от которой до пустой k занятых ячеек,
+    // читает k / Width + 1 групп. Сумма по всем ячейкам кластера длины L
+    // (k = 1..L) — в замкнутом виде
+    static std::size_t groupsBefore(std::size_t length)
+    {
+        const std::size_t w = ControlGroup::Width;
+        const std::size_t q = length / w;
+        const std::size_t r = length % w;
+        return length + w * q * (q - 1) / 2 + q * (r + 1);
+    }
 };
 
-class HashTable
+// Открытая адресация по схеме Robin Hood: при вставке запись, ушедшая от
+// своей домашней ячейки дальше, вытесняет более "богатую" соседку. Удаление
+// сдвигает хвост цепочки назад (backward shift), поэтому меток Deleted нет,
+// а длина пробирования не растёт при постоянных вставках и удалениях.
+// С ControlBytes поиск идёт по отдельному массиву управляющих байтов группами
+// по 16 ячеек, а сами записи читаются только при совпадении тега. Массив
+// длиннее таблицы на 15 байт: хвост повторяет начало, поэтому группа,
+// начатая у конца таблицы, читается одним обращением.
+template<typename HashPolicy = FastMixHash, bool ControlBytes = HASHTABLE_SIMD_PROBE != 0>
+class BasicHashTable
 {
+public:
+    // Результат вставки одной записи (см. bulkInsert)
+    enum class InsertStatus
+    {
+        Inserted,
+        Duplicate,        // полис уже есть в таблице
+        DuplicateInBatch, // полис повторяется внутри пакета
+        Invalid,          // некорректный полис
+    };
+
+    // Ссылка на найденную запись, полученная одним проходом по цепочке.
+    // Действительна до следующего изменения таблицы; extract(Handle)
+    // проверяет её и при необходимости ищет запись по полису заново.
+    class Handle
+    {
+    public:
+        Handle() = default;
+
+        explicit operator bool() const noexcept { return m_record != nullptr; }
+        PolicyId policy() const noexcept { return m_policy; }
+        const Patient &patient() const { return PatientArray[m_record->arrayIndex]; }
+
+    private:
+        friend class BasicHashTable;
+        Handle(HashRecord *record, PolicyId policy) : m_record(record), m_policy(policy) {}
+
+        HashRecord *m_record{nullptr};
+        PolicyId m_policy{};
+    };
+
 private:
+    // Ссылка записи массива на её ячейку: epoch отличает текущую таблицу
+    // от старой, которая ещё переносится после увеличения размера
+    struct SlotRef
+    {
+        std::size_t pos;
+        std::uint32_t epoch;
+    };
+
     HashRecord *m_table{nullptr};
-    std::size_t m_size{MAX_SIZE};
-    std::size_t m_count{0};
+    std::uint8_t *m_ctrl{nullptr};
+    std::size_t m_size{INITIAL_SIZE};
+    std::size_t m_count{0};   // активные записи в обеих таблицах
+    double m_maxLoadFactor{MAX_LOAD_FACTOR};
+
+    // Старая таблица при постепенном рехэше: за каждую операцию изменения
+    // переносится до REHASH_STEP её ячеек. Перенесённая запись удаляется
+    // обратным сдвигом, и курсор проверяет ту же ячейку ещё раз.
+    HashRecord *m_old{nullptr};
+    std::uint8_t *m_oldCtrl{nullptr};
+    std::size_t m_oldSize{0};
+    std::size_t m_oldCount{0};
+    std::size_t m_migrated{0};
+    std::uint32_t m_epoch{0};
+
+    // Пробирование в текущей и в старой таблице
+    ProbeStats m_stats;
+    ProbeStats m_oldStats;
+
+    // Обратные ссылки: индекс записи PatientArray → ячейка в таблице.
+    // По ним fixIndex и getKeyForIndex работают за O(1), без обхода таблицы.
+    std::vector<SlotRef> m_slotOf;
+
+    [[no_unique_address]] HashPolicy m_hash{};
+
+    // Полисы по ФИО; правится вместе с таблицей в insertPatient и extract
+    FioIndex m_byFio;
 
     const std::size_t upos = -1;
 
-    std::size_t hash_function(std::size_t key) const {
-        __uint128_t square = static_cast<__uint128_t>(key) * key;
-        std::string squareStr = uint128_to_string(square);
-        std::size_t len = squareStr.length();
+    std::size_t hash_function(PolicyId policy, std::size_t size) const {
+        return m_hash(policy, size);
+    }
 
-        if (len < DIGITS + 2) {
-            std::size_t fallbackHash = key % m_size;
-            qDebug().noquote() << QString("Hash (%1): квадрат короткий → %2").arg(key).arg(fallbackHash);
-            return fallbackHash;
+    // Поиск активной записи. Цепочку можно обрывать, как только у ячейки
+    // расстояние от дома меньше пройденного: дальше искомой записи быть не может.
+    std::size_t findPos(const HashRecord *table, std::size_t size, PolicyId key) const
+    {
+        if constexpr (ControlBytes)
+            return findPosGroup(table, size, key);
+
+        std::size_t pos = hash_function(key, size);
+
+        TRACE(Trace, Hash, " Ищем позицию: Ключ = %1, Начальная позиция = %2", key, pos);
+
+        for (std::uint32_t dist = 0; dist < size; ++dist)
+        {
+            const HashRecord &record = table[pos];
+
+            if (record.status != Status::Active || record.probeLength < dist)
+            {
+                TRACE(Trace, Hash, "  → Элемент не найден, проб = %1", dist + 1);
+                return upos;
+            }
+
+            if (record.key == key)
+            {
+                TRACE(Trace, Hash, "  → Нашли на позиции = %1, проб = %2", pos, dist + 1);
+                return pos;
+            }
+
+            pos = (pos + 1) % size;
         }
 
-        std::size_t mid = len / 2;
-        std::string midStr = squareStr.substr(mid - DIGITS / 2, DIGITS);
-        std::size_t hashVal = std::stoul(midStr);
-        std::size_t finalHash = hashVal % m_size;
+        TRACE(Trace, Hash, "  → Полный обход таблицы, элемент не найден");
+        return upos;
+    }
 
-        qDebug().noquote() << QString("Hash (%1): квадрат = %2, mid = \"%3\", итог = %4")
-                                  .arg(key)
-                                  .arg(QString::fromStdString(squareStr))
-                                  .arg(QString::fromStdString(midStr))
-                                  .arg(finalHash);
+    // Групповой поиск по управляющим байтам. В цепочке линейного пробирования
+    // нет пустых ячеек, поэтому первая пустая ячейка группы завершает поиск.
+    std::size_t findPosGroup(const HashRecord *table, std::size_t size, PolicyId key) const
+    {
+        const std::uint8_t *ctrl = ctrlOf(table);
+        const std::uint8_t tag = ControlGroup::tagOf(key);
+        std::size_t pos = hash_function(key, size);
 
-        return finalHash;
+        for (std::size_t probed = 0; probed < size; probed += ControlGroup::Width)
+        {
+            ControlGroup group{ctrl + pos};
+            std::uint32_t candidates = group.match(tag);
+            std::uint32_t empty = group.matchEmpty();
+
+            // Совпадения за первой пустой ячейкой к цепочке уже не относятся
+            if (empty)
+                candidates &= (empty & (~empty + 1)) - 1;
+
+            for (; candidates; candidates &= candidates - 1)
+            {
+                std::size_t slot = (pos + std::countr_zero(candidates)) % size;
+                if (table[slot].key == key)
+                {
+                    TRACE(Trace, Hash, "  → Нашли на позиции = %1 (группа с %2)", slot, pos);
+                    return slot;
+                }
+            }
+
+            if (empty)
+                break;
+
+            pos = (pos + ControlGroup::Width) % size;
+        }
+
+        TRACE(Trace, Hash, "  → Элемент %1 не найден", key);
+        return upos;
+    }
+
+    const std::uint8_t *ctrlOf(const HashRecord *table) const
+    {
+        return table == m_table ? m_ctrl : m_oldCtrl;
+    }
+
+    static std::uint8_t *allocCtrl(std::size_t size)
+    {
+        if constexpr (!ControlBytes)
+            return nullptr;
+
+        std::uint8_t *ctrl = new std::uint8_t[size + ControlGroup::Width - 1];
+        std::fill_n(ctrl, size + ControlGroup::Width - 1, ControlGroup::Empty);
+        return ctrl;
+    }
+
+    // Записывает управляющий байт ячейки и его копии в хвосте массива
+    void setCtrl(const HashRecord *table, std::size_t size, std::size_t pos, std::uint8_t value)
+    {
+        if constexpr (ControlBytes)
+        {
+            std::uint8_t *ctrl = const_cast<std::uint8_t *>(ctrlOf(table));
+            ctrl[pos] = value;
+            for (std::size_t mirror = pos; mirror < ControlGroup::Width - 1; mirror += size)
+                ctrl[size + mirror] = value;
+        }
+    }
+
+    ProbeStats &statsOf(const HashRecord *table) { return table == m_table ? m_stats : m_oldStats; }
+
+    // Средняя длина неуспешного поиска при равновероятной домашней ячейке.
+    // В Robin Hood поиск с домашней ячейки h проходит все записи с домашней
+    // ячейкой не дальше h, лежащие начиная с h, и ещё одну ячейку; каждая
+    // запись с расстоянием d попадает так в d + 1 поисков. Отсюда формула.
+    static double unsuccessfulProbe(const ProbeStats &stats, std::size_t size)
+    {
+        return size == 0 ? 0.0 : 1.0 + static_cast<double>(stats.totalProbe + stats.count) / size;
+    }
+
+    // То же для findPosGroup, в группах: поиск идёт до первой группы с пустой
+    // ячейкой, то есть с пустой ячейки — одна группа, а изнутри кластера
+    // зависит от расстояния до его конца (ProbeStats::groupsBefore)
+    static double unsuccessfulGroups(const ProbeStats &stats, std::size_t size)
+    {
+        return size == 0 ? 0.0 : static_cast<double>(size - stats.count + stats.clusterGroups) / size;
+    }
+
+    // С управляющими байтами занятость читается из них, а не из записей
+    bool isActive(const HashRecord *table, std::size_t pos) const
+    {
+        if constexpr (ControlBytes)
+            return (ctrlOf(table)[pos] & ControlGroup::Empty) == 0;
+        else
+            return table[pos].status == Status::Active;
+    }
+
+    // Занятые ячейки подряд слева и справа от pos (саму pos не считая)
+    std::pair<std::size_t, std::size_t> neighbours(const HashRecord *table, std::size_t size, std::size_t pos) const
+    {
+        std::size_t left = 0;
+        while (left + 1 < size && isActive(table, (pos + size - 1 - left) % size))
+            ++left;
+        std::size_t right = 0;
+        while (left + right + 1 < size && isActive(table, (pos + 1 + right) % size))
+            ++right;
+        return {left, right};
+    }
+
+    // Ячейка pos занята: соседние кластеры сливаются через неё
+    void occupyCluster(const HashRecord *table, std::size_t size, std::size_t pos)
+    {
+        ProbeStats &stats = statsOf(table);
+        auto [left, right] = neighbours(table, size, pos);
+        stats.removeCluster(left);
+        stats.removeCluster(right);
+        stats.addCluster(left + right + 1);
+    }
+
+    // Ячейка pos освобождена: её кластер распадается на два
+    void vacateCluster(const HashRecord *table, std::size_t size, std::size_t pos)
+    {
+        ProbeStats &stats = statsOf(table);
+        auto [left, right] = neighbours(table, size, pos);
+        stats.removeCluster(left + right + 1);
+        stats.addCluster(left);
+        stats.addCluster(right);
+    }
+
+    void setSlot(std::size_t arrayIndex, std::size_t pos, std::uint32_t epoch)
+    {
+        m_slotOf[arrayIndex] = {pos, epoch};
     }
 
-    // ИСПРАВЛЕННАЯ функция поиска позиции
-    std::size_t findPos(std::size_t key, bool inserting) const
+    // Вставка Robin Hood; у вытесненных записей правятся обратные ссылки.
+    // Возвращает ячейку, куда легла сама запись record.
+    std::size_t place(HashRecord *table, std::size_t size, std::uint32_t epoch, HashRecord record)
     {
-        std::size_t pos = hash_function(key);
-        std::size_t step = 1; // Простое линейное пробирование вместо сложного
+        return placeAt(table, size, epoch, record, hash_function(record.key, size), 0);
+    }
 
-        qDebug().noquote() << QString(" Ищем позицию: Ключ = %1, Начальная позиция = %2, Шаг = %3")
-                                  .arg(key)
-                                  .arg(pos)
-                                  .arg(step);
+    // То же, но пробирование продолжается с ячейки pos, до которой запись
+    // уже прошла dist шагов (см. probeForInsert)
+    std::size_t placeAt(HashRecord *table, std::size_t size, std::uint32_t epoch,
+                        HashRecord record, std::size_t pos, std::uint32_t dist)
+    {
+        record.status = Status::Active;
+        record.probeLength = dist;
 
-        std::size_t startPos = pos; // Запоминаем начальную позицию для обнаружения зацикливания
+        ProbeStats &stats = statsOf(table);
+        std::size_t placedAt = upos;
 
-        for (std::size_t i = 0; i < m_size; ++i)
+        for (;;)
         {
-            const HashRecord &record = m_table[pos];
-            qDebug().noquote() << QString("  Пробируем [%1]: Позиция = %2, Статус = %3, Ключ = %4")
-                                      .arg(i)
-                                      .arg(pos)
-                                      .arg(record.status == Status::Empty ? "Empty" :
-                                               record.status == Status::Active ? "Active" : "Deleted")
-                                      .arg(record.key);
-
-            // При вставке - ищем пустое место или удаленное
-            if (inserting && (record.status == Status::Empty || record.status == Status::Deleted))
+            HashRecord &slot = table[pos];
+
+            if (slot.status != Status::Active)
             {
-                qDebug().noquote() << QString("  → Нашли свободную позицию = %1").arg(pos);
-                return pos;
+                slot = record;
+                setCtrl(table, size, pos, ControlGroup::tagOf(slot.key));
+                setSlot(slot.arrayIndex, pos, epoch);
+                stats.add(slot.probeLength);
+                occupyCluster(table, size, pos);
+                return placedAt == upos ? pos : placedAt;
             }
 
-            // При поиске - ищем только активную запись с нужным ключом
-            if (!inserting && record.status == Status::Active && record.key == key)
+            if (slot.probeLength < record.probeLength)
             {
-                qDebug().noquote() << QString("  → Нашли на позиции = %1").arg(pos);
-                return pos;
+                TRACE(Trace, Hash, "  Robin Hood: позиция %1 отдана (проб %2 > %3)",
+                      pos, record.probeLength, slot.probeLength);
+                stats.remove(slot.probeLength);
+                stats.add(record.probeLength);
+                std::swap(slot, record);
+                setCtrl(table, size, pos, ControlGroup::tagOf(slot.key));
+                setSlot(slot.arrayIndex, pos, epoch);
+                if (placedAt == upos)
+                    placedAt = pos;
             }
 
-            // При поиске - если дошли до пустой ячейки, элемента нет
-            if (!inserting && record.status == Status::Empty)
+            pos = (pos + 1) % size;
+            ++record.probeLength;
+        }
+    }
+
+    // Один проход по цепочке текущей таблицы: либо находит ключ (found = true),
+    // либо останавливается на ячейке, где запись должна лечь по Robin Hood.
+    // Так проверка дубликата и поиск места для вставки делаются за один обход.
+    std::size_t probeForInsert(PolicyId key, std::uint32_t &dist, bool &found) const
+    {
+        std::size_t pos = hash_function(key, m_size);
+        for (dist = 0;; ++dist)
+        {
+            const HashRecord &slot = m_table[pos];
+            if (slot.status != Status::Active || slot.probeLength < dist)
             {
-                qDebug().noquote() << QString("  → Дошли до пустой ячейки, элемент не найден");
-                return upos;
+                found = false;
+                return pos;
             }
+            if (slot.key == key)
+            {
+                found = true;
+                return pos;
+            }
+            pos = (pos + 1) % m_size;
+        }
+    }
 
-            pos = (pos + step) % m_size;
+    // Удаление обратным сдвигом: следующие записи цепочки, стоящие не в своей
+    // домашней ячейке, сдвигаются на одну позицию назад.
+    void eraseAt(HashRecord *table, std::size_t size, std::uint32_t epoch, std::size_t pos)
+    {
+        ProbeStats &stats = statsOf(table);
+        stats.remove(table[pos].probeLength);
 
-            // Проверяем зацикливание
-            if (i > 0 && pos == startPos) {
-                qDebug().noquote() << "  → Полный обход таблицы, больше нет мест";
-                return upos;
+        std::size_t next = (pos + 1) % size;
+        while (table[next].status == Status::Active && table[next].probeLength > 0)
+        {
+            stats.shiftBack(table[next].probeLength);
+            table[pos] = table[next];
+            --table[pos].probeLength;
+            setCtrl(table, size, pos, ControlGroup::tagOf(table[pos].key));
+            setSlot(table[pos].arrayIndex, pos, epoch);
+
+            pos = next;
+            next = (next + 1) % size;
+        }
+        table[pos] = HashRecord{};
+        setCtrl(table, size, pos, ControlGroup::Empty);
+        vacateCluster(table, size, pos);
+    }
+
+    // Активная запись с ключом: сначала в текущей таблице, затем в старой
+    const HashRecord *locate(PolicyId key) const
+    {
+        std::size_t pos = findPos(m_table, m_size, key);
+        if (pos != upos)
+            return &m_table[pos];
+
+        if (m_old)
+        {
+            pos = findPos(m_old, m_oldSize, key);
+            if (pos != upos)
+                return &m_old[pos];
+        }
+        return nullptr;
+    }
+
+    HashRecord *locate(PolicyId key)
+    {
+        return const_cast<HashRecord *>(std::as_const(*this).locate(key));
+    }
+
+    HashRecord *recordOf(std::size_t arrayIndex) const
+    {
+        if (arrayIndex >= m_slotOf.size() || m_slotOf[arrayIndex].pos == upos)
+            return nullptr;
+
+        const SlotRef &ref = m_slotOf[arrayIndex];
+        return ref.epoch == m_epoch ? &m_table[ref.pos] : &m_old[ref.pos];
+    }
+
+    bool inCurrentTable(const HashRecord *record) const
+    {
+        return record >= m_table && record < m_table + m_size;
+    }
+
+    // Ссылка всё ещё указывает на активную запись с этим полисом
+    bool owns(const HashRecord *record, PolicyId key) const
+    {
+        bool inTable = inCurrentTable(record)
+                       || (m_old && record >= m_old && record < m_old + m_oldSize);
+        return inTable && record->status == Status::Active && record->key == key;
+    }
+
+    // Переносит до budget ячеек старой таблицы в текущую
+    void rehashStep(std::size_t budget)
+    {
+        if (!m_old)
+            return;
+
+        for (; budget > 0 && m_oldCount > 0 && m_migrated < m_oldSize; --budget)
+        {
+            HashRecord &record = m_old[m_migrated];
+            if (record.status != Status::Active)
+            {
+                ++m_migrated;
+                continue;
             }
 
-            qDebug().noquote() << QString("  → Коллизия, следующая позиция = %1").arg(pos);
+            HashRecord moved = record;
+            eraseAt(m_old, m_oldSize, m_epoch - 1, m_migrated);
+            --m_oldCount;
+            place(m_table, m_size, m_epoch, moved);
         }
 
-        qDebug().noquote() << "  → Таблица заполнена, нет больше мест";
-        return upos;
+        if (m_oldCount == 0)
+        {
+            TRACE(Info, Hash, "Рехэш завершён: старая таблица (%1) освобождена", m_oldSize);
+            delete[] m_old;
+            delete[] m_oldCtrl;
+            m_old = nullptr;
+            m_oldCtrl = nullptr;
+            m_oldSize = 0;
+            m_migrated = 0;
+            m_oldStats = {};
+        }
     }
 
-    std::size_t stringToKey(const std::string &str) const
+    // Заводит таблицу вдвое больше; записи переносятся постепенно в rehashStep
+    void startRehash()
     {
-        std::size_t key = 0;
-        QString debugStr = QString::fromStdString(str);
+        finishRehash();
+
+        TRACE(Info, Hash, "Рехэш: %1 → %2 ячеек, записей = %3", m_size, m_size * 2, m_count);
+
+        m_old = m_table;
+        m_oldCtrl = m_ctrl;
+        m_oldSize = m_size;
+        m_oldCount = m_count;
+        m_migrated = 0;
+        m_oldStats = std::move(m_stats);
+        m_stats = {};
+
+        m_size *= 2;
+        m_table = new HashRecord[m_size]{};
+        m_ctrl = allocCtrl(m_size);
+        ++m_epoch;
+    }
+
+    // Немедленный перенос всех записей в таблицу размера newSize
+    void rebuild(std::size_t newSize)
+    {
+        finishRehash();
+
+        TRACE(Info, Hash, "Перестройка: %1 → %2 ячеек, записей = %3", m_size, newSize, m_count);
+
+        HashRecord *oldTable = m_table;
+        std::uint8_t *oldCtrl = m_ctrl;
+        std::size_t oldSize = m_size;
 
-        for (char c : str)
+        m_size = newSize;
+        m_table = new HashRecord[m_size]{};
+        m_ctrl = allocCtrl(m_size);
+        m_stats = {};
+        ++m_epoch;
+
+        for (std::size_t i = 0; i < oldSize; ++i)
+            if (oldTable[i].status == Status::Active)
+                place(m_table, m_size, m_epoch, oldTable[i]);
+
+        delete[] oldTable;
+        delete[] oldCtrl;
+    }
+
+    // Вставка без роста таблицы. Записи с индексом массива от batchStart
+    // считаются добавленными тем же пакетом.
+    InsertStatus insertPatient(PolicyId OMS, Patient &&patient, std::size_t batchStart,
+                               HashRecord **slot = nullptr)
+    {
+        if (!OMS.isValid())
+            return InsertStatus::Invalid;
+
+        if (m_old)
         {
-            if (std::isdigit(c))
+            std::size_t oldPos = findPos(m_old, m_oldSize, OMS);
+            if (oldPos != upos)
             {
-                key = key * 10 + (c - '0');
+                if (slot)
+                    *slot = &m_old[oldPos];
+                return InsertStatus::Duplicate;
             }
         }
 
-        qDebug().noquote() << QString("Перевели строку в ключ: \"%1\" → %2").arg(debugStr).arg(key);
-        return key;
+        std::uint32_t dist = 0;
+        bool found = false;
+        std::size_t pos = probeForInsert(OMS, dist, found);
+        if (found)
+        {
+            TRACE(Debug, Hash, "Нашли дубликат: %1", OMS);
+            if (slot)
+                *slot = &m_table[pos];
+            return m_table[pos].arrayIndex >= batchStart ? InsertStatus::DuplicateInBatch
+                                                         : InsertStatus::Duplicate;
+        }
+
+        m_byFio.add(patient, OMS);
+        PatientArray.Add(std::move(patient));
+
+        std::size_t arrayIdx = PatientArray.Size() - 1;
+        m_slotOf.resize(PatientArray.Size(), SlotRef{upos, 0});
+        pos = placeAt(m_table, m_size, m_epoch, {OMS, arrayIdx, Status::Active}, pos, dist);
+        ++m_count;
+        if (slot)
+            *slot = &m_table[pos];
+
+        TRACE(Debug, Hash, "Успешная вставка: Позиция = %1, Индекс Массива = %2, Новый размер = %3",
+              pos, arrayIdx, m_count);
+        return InsertStatus::Inserted;
     }
 
 public:
-    HashTable()
+    explicit BasicHashTable(std::size_t initialSize = INITIAL_SIZE, double maxLoadFactor = MAX_LOAD_FACTOR)
+        : m_size(initialSize > 0 ? initialSize : 1), m_maxLoadFactor(maxLoadFactor)
     {
+        if (!(maxLoadFactor > 0.0 && maxLoadFactor < 1.0))
+            throw std::invalid_argument("Коэффициент заполнения должен быть в интервале (0, 1)");
+
         m_table = new HashRecord[m_size]{};
-        qDebug().noquote() << QString("HashTable: Размер = %1").arg(m_size);
+        m_ctrl = allocCtrl(m_size);
+        qDebug().noquote() << QString("HashTable: Размер = %1, Макс. заполнение = %2")
+                                  .arg(m_size)
+                                  .arg(m_maxLoadFactor);
     }
 
-    ~HashTable()
+    BasicHashTable(const BasicHashTable &) = delete;
+    BasicHashTable &operator=(const BasicHashTable &) = delete;
+
+    ~BasicHashTable()
     {
         delete[] m_table;
+        delete[] m_old;
+        delete[] m_ctrl;
+        delete[] m_oldCtrl;
     }
 
     std::size_t getSize() const noexcept { return m_size; }
     std::size_t getCount() const noexcept { return m_count; }
+    double getMaxLoadFactor() const noexcept { return m_maxLoadFactor; }
+    bool isRehashing() const noexcept { return m_old != nullptr; }
+
+    // Доносит незавершённый рехэш целиком (например, перед показом ячеек таблицы)
+    void finishRehash()
+    {
+        if (m_old)
+            rehashStep(m_oldSize + m_oldCount);
+    }
 
-    bool insert(const std::string &OMS, const std::string &fn, int day, Month month, int year)
+    // Вставка без повторного поиска: один проход по цепочке и находит
+    // существующую запись, и даёт место для новой. Возвращает ссылку на
+    // запись и true, если она добавлена (false — полис уже был, patient
+    // не используется).
+    std::pair<Handle, bool> tryEmplace(PolicyId OMS, Patient &&patient)
     {
-        std::string surname, name, middlename;
-        std::istringstream in(fn);
-        in >> surname >> name >> middlename;
+        TRACE(Info, Hash, "=== Вставка: %1 ===", OMS);
 
-        Date date{day, month, year};
-        Patient patient{surname, name, middlename, date};
+        if (!OMS.isValid())
+            throw std::invalid_argument("Некорректный полис");
 
-        qDebug().noquote() << QString("=== Вставка: \"%1\" ===").arg(QString::fromStdString(OMS));
+        rehashStep(REHASH_STEP);
 
-        std::size_t numKey = stringToKey(OMS);
+        if (m_count + 1 > m_maxLoadFactor * m_size)
+            startRehash();
 
-        // Проверяем, не переполнена ли таблица
-        if (m_count >= m_size) {
-            qDebug().noquote() << "Хэш-таблица переполнена";
-            throw std::runtime_error("Хэш-таблица переполнена");
-        }
+        HashRecord *slot = nullptr;
+        InsertStatus status = insertPatient(OMS, std::move(patient), upos, &slot);
+        return {Handle(slot, OMS), status == InsertStatus::Inserted};
+    }
 
-        if (findPos(numKey, false) != upos)
-        {
-            qDebug().noquote() << "Нашли дубликат!";
-            throw std::runtime_error("Дубликат");
-        }
+    // Пакетная загрузка: таблица и массив один раз расширяются под итоговое
+    // число записей, затем каждая запись вставляется за один проход по цепочке
+    // (он же ищет дубликаты — и среди прежних записей, и внутри пакета).
+    // Возвращает статус для каждой записи пакета в том же порядке.
+    std::vector<InsertStatus> bulkInsert(std::vector<std::pair<PolicyId, Patient>> batch)
+    {
+        TRACE(Info, Hash, "=== Пакетная вставка: %1 записей ===", batch.size());
 
-        if (!PatientArray.Add(patient))
-        {
-            qDebug().noquote() << "Массив полон";
-            throw std::runtime_error("Хранилище заполнено");
-        }
+        reserve(m_count + batch.size());
+        PatientArray.Reserve(PatientArray.Size() + batch.size());
 
-        std::size_t arrayIdx = PatientArray.Size() - 1;
-        std::size_t pos = findPos(numKey, true);
+        const std::size_t batchStart = PatientArray.Size();
+        std::vector<InsertStatus> statuses;
+        statuses.reserve(batch.size());
 
-        if (pos == upos)
-        {
-            qDebug().noquote() << "Не удалось найти место";
-            throw std::runtime_error("Не удалось найти место");
-        }
+        for (auto &[policy, patient] : batch)
+            statuses.push_back(insertPatient(policy, std::move(patient), batchStart));
 
-        m_table[pos] = {numKey, arrayIdx, Status::Active};
-        ++m_count;
+        TRACE(Info, Hash, "Пакетная вставка: добавлено %1 из %2", PatientArray.Size() - batchStart, batch.size());
+        return statuses;
+    }
+
+    // Расширяет таблицу сразу так, чтобы count записей уместились без рехэша
+    void reserve(std::size_t count)
+    {
+        finishRehash();
+
+        std::size_t newSize = m_size;
+        while (count > m_maxLoadFactor * newSize)
+            newSize *= 2;
 
-        qDebug().noquote() << QString("Успешная вставка: Позиция = %1, Индекс Массива = %2, Новый размер = %3")
-                                  .arg(pos)
-                                  .arg(arrayIdx)
-                                  .arg(m_count);
-        return true;
+        if (newSize != m_size)
+            rebuild(newSize);
     }
 
     const HashRecord &getRecord(size_t index) const
@@ -223,101 +839,133 @@ public:
         return m_table[index];
     }
 
-    std::size_t getHashValue(const std::string& policy) const
-    {
-        std::size_t key = stringToKey(policy);
-        return hash_function(key);
-    }
-
-    std::size_t getHashValue(std::size_t key) const {
-        return hash_function(key);
+    std::size_t getHashValue(PolicyId key) const {
+        return hash_function(key, m_size);
     }
 
-    const Patient *get(const std::string &OMS) const
+    const Patient *get(PolicyId OMS) const
     {
-        qDebug().noquote() << QString("=== Получение информации клиента: \"%1\" ===").arg(QString::fromStdString(OMS));
+        TRACE(Info, Hash, "=== Получение информации клиента: %1 ===", OMS);
 
-        std::size_t key = stringToKey(OMS);
-        std::size_t pos = findPos(key, false);
+        const HashRecord *record = locate(OMS);
 
-        if (pos == upos)
+        if (!record)
         {
-            qDebug().noquote() << "Не найдена запись";
+            TRACE(Debug, Hash, "Не найдена запись");
             return nullptr;
         }
 
-        qDebug().noquote() << QString("Найден на позиции = %1, Индекс массива = %2")
-                                  .arg(pos)
-                                  .arg(m_table[pos].arrayIndex);
-        return &PatientArray[m_table[pos].arrayIndex];
+        TRACE(Debug, Hash, "Найден, Индекс массива = %1", record->arrayIndex);
+        return &PatientArray[record->arrayIndex];
     }
 
-    bool remove(const std::string &OMS)
+    // Ссылка на запись с полисом; пустая, если записи нет
+    Handle find(PolicyId OMS) const
     {
-        qDebug().noquote() << QString("=== Удаление: \"%1\" ===").arg(QString::fromStdString(OMS));
+        TRACE(Info, Hash, "=== Поиск: %1 ===", OMS);
+        return Handle(const_cast<HashRecord *>(locate(OMS)), OMS);
+    }
+
+    bool remove(PolicyId OMS) { return extract(OMS).has_value(); }
 
-        std::size_t key = stringToKey(OMS);
-        std::size_t pos = findPos(key, false);
+    // Удаляет запись и возвращает пациента; nullopt — если записи нет
+    std::optional<Patient> extract(PolicyId OMS) { return extract(find(OMS)); }
 
-        if (pos == upos)
+    // Удаление по ссылке из find / tryEmplace — без повторного поиска
+    std::optional<Patient> extract(Handle handle)
+    {
+        TRACE(Info, Hash, "=== Удаление: %1 ===", handle.m_policy);
+
+        HashRecord *record = handle.m_record;
+        if (record && !owns(record, handle.m_policy))
         {
-            qDebug().noquote() << "Ключ не найден";
-            return false;
+            TRACE(Debug, Hash, "Ссылка устарела, повторный поиск");
+            record = locate(handle.m_policy);
         }
 
-        qDebug().noquote() << QString("Удаление с позиции = %1, Индекс в массиве = %2")
-                                  .arg(pos)
-                                  .arg(m_table[pos].arrayIndex);
+        if (!record)
+        {
+            TRACE(Debug, Hash, "Ключ не найден");
+            return std::nullopt;
+        }
 
-        PatientArray.Remove(m_table[pos].arrayIndex, *this);
-        m_table[pos].status = Status::Deleted; // Помечаем как удаленное, а не Empty
-        m_table[pos].key = 0;
+        std::size_t arrayIdx = record->arrayIndex;
+        TRACE(Debug, Hash, "Удаление, Индекс в массиве = %1", arrayIdx);
+
+        // Сначала ячейка освобождается обратным сдвигом (он правит ссылки
+        // сдвинутых записей), затем запись уходит из массива
+        if (inCurrentTable(record)) {
+            eraseAt(m_table, m_size, m_epoch, record - m_table);
+        } else {
+            eraseAt(m_old, m_oldSize, m_epoch - 1, record - m_old);
+            --m_oldCount;
+        }
+        m_slotOf[arrayIdx] = {upos, 0};
         --m_count;
 
-        return true;
+        m_byFio.remove(PatientArray[arrayIdx], handle.m_policy);
+        std::optional<Patient> patient(std::move(PatientArray[arrayIdx]));
+        PatientArray.Remove(arrayIdx, *this);
+        // Последняя запись массива переехала на место удалённой (или удалена она сама)
+        m_slotOf.resize(PatientArray.Size());
+
+        // Шаг рехэша — после удаления: до него ссылка указывала на верную ячейку
+        rehashStep(REHASH_STEP);
+
+        return patient;
     }
 
     void fixIndex(std::size_t oldIdx, std::size_t newIdx)
     {
-        qDebug().noquote() << QString("Исправили индекс: %1 → %2").arg(oldIdx).arg(newIdx);
+        TRACE(Debug, Hash, "Исправили индекс: %1 → %2", oldIdx, newIdx);
 
-        for (std::size_t i = 0; i < m_size; ++i)
-            if (m_table[i].status == Status::Active && m_table[i].arrayIndex == oldIdx)
-            {
-                m_table[i].arrayIndex = newIdx;
-                qDebug().noquote() << QString("  Обновили позицию = %1").arg(i);
-                break;
-            }
+        HashRecord *record = recordOf(oldIdx);
+        if (!record)
+            return;
+
+        record->arrayIndex = newIdx;
+        m_slotOf[newIdx] = m_slotOf[oldIdx];
+        m_slotOf[oldIdx] = {upos, 0};
     }
 
-    std::string getKeyForIndex(std::size_t index) const {
-        for (std::size_t i = 0; i < m_size; ++i) {
-            if (m_table[i].status == Status::Active && m_table[i].arrayIndex == index) {
-                return std::to_string(m_table[i].key);
-            }
-        }
-        return "";
+    // Полис записи массива; PolicyId{} — если запись не найдена
+    PolicyId getKeyForIndex(std::size_t index) const {
+        const HashRecord *record = recordOf(index);
+        if (!record || record->status != Status::Active)
+            return PolicyId{};
+        return record->key;
     }
 
-    bool exists(const std::string& OMS) const {
-        qDebug().noquote() << QString("=== Проверка существования: \"%1\" ===")
-                                  .arg(QString::fromStdString(OMS));
+    bool exists(PolicyId OMS) const {
+        bool found = locate(OMS) != nullptr;
+        TRACE(Info, Hash, "=== Проверка существования: %1 → %2 ===", OMS, found);
 
-        std::size_t key = stringToKey(OMS);
-        std::size_t pos = findPos(key, false);
+        return found;
+    }
 
-        bool found = (pos != upos);
-        qDebug().noquote() << QString("→ Результат: %1").arg(found ? "НАЙДЕН" : "НЕ НАЙДЕН");
+    // Полисы пациентов с заданным ФИО; регистр и лишние пробелы не учитываются
+    const std::vector<PolicyId> &findByFio(std::string_view fullName) const
+    {
+        return m_byFio.find(fullName);
+    }
 
-        return found;
+    const std::vector<PolicyId> &findByFio(std::u16string_view fullName) const
+    {
+        return m_byFio.find(fullName);
     }
 
-    std::vector<std::string> getAllPolicies() const {
-        std::vector<std::string> policies;
+    std::vector<PolicyId> getAllPolicies() const {
+        std::vector<PolicyId> policies;
+        policies.reserve(m_count);
 
         for (std::size_t i = 0; i < m_size; ++i) {
             if (m_table[i].status == Status::Active) {
-                policies.push_back(m_table[i].getKey());
+                policies.push_back(m_table[i].key);
+            }
+        }
+        for (std::size_t i = m_migrated; i < m_oldSize; ++i) {
+            if (m_old[i].status == Status::Active) {
+                policies.push_back(m_old[i].key);
             }
         }
 
@@ -330,16 +978,78 @@ public:
         std::size_t usedSlots;
         std::size_t emptySlots;
         double loadFactor;
+
+        // Пробирование (обе таблицы, если идёт рехэш)
+        std::size_t tombstones;          // меток Deleted нет (обратный сдвиг) — всегда 0
+        std::size_t displaced;           // записи не в своей домашней ячейке
+        std::uint32_t maxProbeLength;    // ProbeStats::HistogramSize - 1 означает "и больше"
+        std::size_t longestCluster;      // наибольшая серия занятых ячеек подряд
+        double avgSuccessfulProbe;       // ячеек на поиск существующего ключа
+        // На поиск отсутствующего ключа: ячеек, а при поиске группами
+        // (ControlBytes) — прочитанных групп управляющих байтов
+        double avgUnsuccessfulProbe;
+        bool probeByGroups;
+        std::array<std::size_t, ProbeStats::HistogramSize> probeHistogram;
     };
 
+    // Все поля берутся из счётчиков, которые ведутся при изменениях, — O(1)
     Statistics getStatistics() const {
         Statistics stats;
         stats.totalSlots = m_size;
         stats.usedSlots = m_count;
-        stats.emptySlots = m_size - m_count;
+        stats.emptySlots = m_size > m_count ? m_size - m_count : 0;
         stats.loadFactor = static_cast<double>(m_count) / m_size;
 
+        stats.tombstones = 0;
+        stats.longestCluster = std::max(m_stats.longestCluster, m_oldStats.longestCluster);
+        stats.maxProbeLength = 0;
+        for (std::size_t d = 0; d < ProbeStats::HistogramSize; ++d) {
+            stats.probeHistogram[d] = m_stats.histogram[d] + m_oldStats.histogram[d];
+            if (stats.probeHistogram[d] > 0)
+                stats.maxProbeLength = static_cast<std::uint32_t>(d);
+        }
+        stats.displaced = m_count - stats.probeHistogram[0];
+
+        std::size_t totalProbe = m_stats.totalProbe + m_oldStats.totalProbe;
+        stats.avgSuccessfulProbe = m_count == 0 ? 0.0 : 1.0 + static_cast<double>(totalProbe) / m_count;
+        // Отсутствующий ключ ищется в обеих таблицах
+        stats.probeByGroups = ControlBytes;
+        if constexpr (ControlBytes)
+            stats.avgUnsuccessfulProbe = unsuccessfulGroups(m_stats, m_size)
+                                         + (m_old ? unsuccessfulGroups(m_oldStats, m_oldSize) : 0.0);
+        else
+            stats.avgUnsuccessfulProbe = unsuccessfulProbe(m_stats, m_size)
+                                         + (m_old ? unsuccessfulProbe(m_oldStats, m_oldSize) : 0.0);
+
         return stats;
     }
+
+    // Сводка статистики в лог — без окна отладки (например, после загрузки файла)
+    void dumpStatistics() const {
+        Statistics stats = getStatistics();
+
+        qDebug().noquote() << QString("HashTable: %1/%2 ячеек (%3%), смещено %4, удалённых меток %5")
+                                  .arg(stats.usedSlots)
+                                  .arg(stats.totalSlots)
+                                  .arg(stats.loadFactor * 100, 0, 'f', 1)
+                                  .arg(stats.displaced)
+                                  .arg(stats.tombstones);
+        qDebug().noquote() << QString("HashTable: проб успешный/неуспешный = %1/%2, макс. проб = %3, длиннейший кластер = %4")
+                                  .arg(stats.avgSuccessfulProbe, 0, 'f', 2)
+                                  .arg(QString::number(stats.avgUnsuccessfulProbe, 'f', 2)
+                                       + (stats.probeByGroups ? QString(" гр.") : QString()))
+                                  .arg(stats.maxProbeLength)
+                                  .arg(stats.longestCluster);
+
+        QString histogram;
+        for (std::size_t d = 0; d <= stats.maxProbeLength; ++d)
+            histogram += QString(" %1:%2").arg(d).arg(stats.probeHistogram[d]);
+        qDebug().noquote() << "HashTable: гистограмма проб" << histogram;
+    }
 };
+
+// Рабочая таблица пациентов — с быстрым перемешиванием;
+// AuditHashTable раскладывает записи по прежней схеме середины квадрата
+using HashTable = BasicHashTable<FastMixHash>;
+using AuditHashTable = BasicHashTable<MidSquareHash>;
 #endif
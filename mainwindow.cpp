@@ -24,8 +24,10 @@
 #include <cctype>
 #include <cmath>
 #include <climits>
+#include <limits>
 #include <map>
 #include <functional>
+#include <tuple>
 #include <QLabel>
 #include "array.h"
 #include "hashtable.hpp"
@@ -34,11 +36,62 @@
 
 
 
-extern Array<Patient, 1000> PatientArray;
-extern Array<Appointment, 1000> AppointmentArray;
+extern PatientStore PatientArray;
+extern AppointmentStore AppointmentArray;
 
-// Глобальная переменная для доступа к MainWindow из DateTreeNodeItem
-static MainWindow* g_mainWindow = nullptr;
+static QString policyToQString(PolicyId policy) {
+    if (!policy.isValid()) return QString();
+    return QString::fromStdString(policy.toString());
+}
+
+// UTF-16 данные QString для поиска без временной std::string
+static std::u16string_view utf16Of(QStringView text) {
+    return std::u16string_view(text.utf16(), static_cast<std::size_t>(text.size()));
+}
+
+// Полис из текста интерфейса: цифры читаются прямо из UTF-16 данных
+// QString, без временной std::string
+static bool parsePolicy(QStringView text, PolicyId& policy) {
+    return PolicyId::parse(utf16Of(text.trimmed()), policy);
+}
+
+// Полис строки файла — её первые четыре группы цифр: разбирается префикс
+// строки как есть, без склейки групп
+static bool parseLinePolicy(QStringView line, PolicyId& policy) {
+    qsizetype end = 0;
+    for (int group = 0; group < 4; ++group) {
+        while (end < line.size() && line[end] == QLatin1Char(' '))
+            ++end;
+        while (end < line.size() && line[end] != QLatin1Char(' '))
+            ++end;
+    }
+    return parsePolicy(line.left(end), policy);
+}
+
+// Пары (ключ, индекс приёма) для AVLTree::buildFromSorted: по возрастанию
+// ключа, внутри ключа — в порядке индексов (как при поочерёдной вставке)
+template<typename Key, typename KeyOf>
+static std::vector<std::pair<Key, std::size_t>> sortedAppointmentKeys(KeyOf keyOf) {
+    std::vector<std::pair<Key, std::size_t>> entries;
+    entries.reserve(AppointmentArray.Size());
+    for (std::size_t i = 0; i < AppointmentArray.Size(); ++i)
+        entries.emplace_back(keyOf(i), i);
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    return entries;
+}
+
+// Хранилище приёмов сообщает о переносе записи (Remove → fixIndex)
+// одному адресату; рассылка передаёт сообщение всем деревьям
+template<typename... Trees>
+struct FixIndexFanOut {
+    std::tuple<Trees&...> trees;
+
+    void fixIndex(std::size_t oldIdx, std::size_t newIdx) {
+        std::apply([&](auto&... tree) { (tree.fixIndex(oldIdx, newIdx), ...); }, trees);
+    }
+};
 
 class DateTreeNodeItem : public QGraphicsEllipseItem
 {
@@ -105,22 +158,19 @@ public:
             if (idx < AppointmentArray.Size()) {
                 const Appointment& app = AppointmentArray[idx];
 
-                // ИСПРАВЛЕНИЕ: Получаем полис через глобальную переменную
-                QString policy = "НЕТ_ПОЛИСА";
-                if (g_mainWindow && idx < g_mainWindow->appointmentPolicies.size()) {
-                    policy = QString::fromStdString(g_mainWindow->appointmentPolicies[idx]);
-
+                QString policy = policyToQString(app.policy);
+                if (policy.isEmpty()) {
+                    policy = "НЕТ_ПОЛИСА";
+                } else if (policy.length() > 8) {
                     // Сокращаем полис для отображения
-                    if (policy.length() > 8) {
-                        policy = "..." + policy.right(4);
-                    }
+                    policy = "..." + policy.right(4);
                 }
 
                 tooltip += QString("%1. [%2] %3 → %4 (полис: %5)\n")
                                .arg(i + 1)
                                .arg(idx)
-                               .arg(QString::fromStdString(app.doctorType))
-                               .arg(QString::fromStdString(app.diagnosis))
+                               .arg(QString::fromStdString(DoctorTypes[app.doctorId]))
+                               .arg(QString::fromStdString(Diagnoses[app.diagnosisId]))
                                .arg(policy);
             } else {
                 tooltip += QString("%1. [%2]  ОШИБКА: индекс вне массива!\n")
@@ -161,21 +211,20 @@ protected:
                 if (idx < AppointmentArray.Size()) {
                     const Appointment& app = AppointmentArray[idx];
 
-                    details += QString(" Врач: %1\n").arg(QString::fromStdString(app.doctorType));
-                    details += QString(" Диагноз: %1\n").arg(QString::fromStdString(app.diagnosis));
+                    details += QString(" Врач: %1\n").arg(QString::fromStdString(DoctorTypes[app.doctorId]));
+                    details += QString(" Диагноз: %1\n").arg(QString::fromStdString(Diagnoses[app.diagnosisId]));
                     details += QString(" Дата: %1.%2.%3\n")
                                    .arg(app.appointmentDate.day, 2, 10, QChar('0'))
                                    .arg(static_cast<int>(app.appointmentDate.month), 2, 10, QChar('0'))
                                    .arg(app.appointmentDate.year);
 
-                    // ИСПРАВЛЕНИЕ: Ищем полис через глобальную переменную
-                    if (g_mainWindow && idx < g_mainWindow->appointmentPolicies.size()) {
-                        QString policy = QString::fromStdString(g_mainWindow->appointmentPolicies[idx]);
-                        details += QString("Полис ОМС: %1\n").arg(policy);
+                    if (app.policy.isValid()) {
+                        PolicyId policy = app.policy;
+                        details += QString("Полис ОМС: %1\n").arg(policyToQString(policy));
 
                         // Ищем пациента
                         if (m_hashTable) {
-                            const Patient* patient = m_hashTable->get(policy.toStdString());
+                            const Patient* patient = m_hashTable->get(policy);
                             if (patient) {
                                 details += QString("   👤 Пациент: %1 %2 %3\n")
                                                .arg(QString::fromStdString(patient->surname))
@@ -288,10 +337,10 @@ bool isValidDate(const Date& date) {
 class TreeNodeItem : public QGraphicsEllipseItem
 {
 public:
-    TreeNodeItem(const QString& key, const std::vector<std::size_t>& indices,
+    TreeNodeItem(PolicyId policy, const std::vector<std::size_t>& indices,
                  HashTable* hashTable, qreal x, qreal y, qreal width = 100, qreal height = 50)
         : QGraphicsEllipseItem(x - width/2, y - height/2, width, height)
-        , m_key(key), m_indices(indices), m_hashTable(hashTable)
+        , m_policy(policy), m_key(policyToQString(policy)), m_indices(indices), m_hashTable(hashTable)
     {
         QColor nodeColor;
         if (indices.size() == 1) {
@@ -308,7 +357,7 @@ public:
         setFlag(QGraphicsItem::ItemIsFocusable, true);
         setAcceptHoverEvents(true);
 
-        QString displayKey = key;
+        QString displayKey = m_key;
         if (displayKey.length() > 12) {
             displayKey = displayKey.left(4) + "..." + displayKey.right(4);
         }
@@ -333,7 +382,7 @@ public:
                               .arg(m_key).arg(m_indices.size());
 
         if (m_hashTable) {
-            const Patient* patient = m_hashTable->get(m_key.toStdString());
+            const Patient* patient = m_hashTable->get(m_policy);
             if (patient) {
                 tooltip += QString("Пациент: %1 %2 %3\n")
                                .arg(QString::fromStdString(patient->surname))
@@ -351,8 +400,8 @@ public:
                 const Appointment& app = AppointmentArray[m_indices[i]];
                 tooltip += QString("%1. %2 - %3 (%4.%5.%6)\n")
                                .arg(i + 1)
-                               .arg(QString::fromStdString(app.doctorType))
-                               .arg(QString::fromStdString(app.diagnosis))
+                               .arg(QString::fromStdString(DoctorTypes[app.doctorId]))
+                               .arg(QString::fromStdString(Diagnoses[app.diagnosisId]))
                                .arg(app.appointmentDate.day, 2, 10, QChar('0'))
                                .arg(static_cast<int>(app.appointmentDate.month), 2, 10, QChar('0'))
                                .arg(app.appointmentDate.year);
@@ -415,6 +464,7 @@ protected:
     }
 
 private:
+    PolicyId m_policy;
     QString m_key;
     std::vector<std::size_t> m_indices;
     HashTable* m_hashTable;
@@ -539,7 +589,7 @@ void MainWindow::createTabs() {
     reportTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
     fioFilterEdit = new QLineEdit(this);
-    fioFilterEdit->setPlaceholderText("ФИО пациента (точно)");
+    fioFilterEdit->setPlaceholderText("ФИО пациента (без учёта регистра)");
 
     doctorFilterEdit = new QLineEdit(this);
     doctorFilterEdit->setPlaceholderText("Тип врача");
@@ -549,13 +599,20 @@ void MainWindow::createTabs() {
     dateFilterEdit->setCalendarPopup(true);
     dateFilterEdit->setDate(QDate::currentDate());
 
+    dateToFilterEdit = new QDateEdit(this);
+    dateToFilterEdit->setDisplayFormat("dd.MM.yyyy");
+    dateToFilterEdit->setCalendarPopup(true);
+    dateToFilterEdit->setDate(QDate::currentDate());
+
     QHBoxLayout* filterLayout = new QHBoxLayout();
     filterLayout->addWidget(new QLabel("ФИО:"));
     filterLayout->addWidget(fioFilterEdit);
     filterLayout->addWidget(new QLabel("Врач:"));
     filterLayout->addWidget(doctorFilterEdit);
-    filterLayout->addWidget(new QLabel("Дата:"));
+    filterLayout->addWidget(new QLabel("Период: с"));
     filterLayout->addWidget(dateFilterEdit);
+    filterLayout->addWidget(new QLabel("по"));
+    filterLayout->addWidget(dateToFilterEdit);
 
     QVBoxLayout* reportLayout = new QVBoxLayout();
     reportLayout->addLayout(filterLayout);
@@ -647,9 +704,8 @@ void MainWindow::updateCurrentTree() {
             showEmptyTreeMessage("Основное дерево (по ОМС) пустое\nЗагрузите приёмы");
         }
     } else {
-        // Дерево по датам - ВСЕГДА перестраиваем перед отображением
+        // Дерево по датам ведётся вместе с деревом ОМС и всегда актуально
         if (AppointmentArray.Size() > 0) {
-            buildDateTreeForReport();
             auto root = dateTree.getRoot();
             if (root) {
                 drawTreeByDate(root);
@@ -747,33 +803,51 @@ void MainWindow::loadPatientsFromFile() {
     }
 
     QTextStream in(&file);
-    int loaded = 0;
     int lineNumber = 0;
 
+    // Сначала разбираем весь файл, затем вставляем пакетом
+    std::vector<std::pair<PolicyId, Patient>> batch;
+    std::vector<int> batchLines;
+
     while (!in.atEnd()) {
         QString line = in.readLine().trimmed();
         lineNumber++;
 
         if (line.isEmpty()) continue;
 
-        std::string policy;
+        PolicyId policy;
         Patient patient;
 
         if (parsePatientLine(line, policy, patient)) {
-            try {
-                hashTable.insert(policy,
-                                 patient.surname + " " + patient.name + " " + patient.middlename,
-                                 patient.birthDate.day, patient.birthDate.month, patient.birthDate.year);
-                loaded++;
-            } catch (const std::exception& e) {
-                qDebug() << "Ошибка вставки пациента на строке" << lineNumber << ":" << e.what();
-            }
+            batch.emplace_back(policy, std::move(patient));
+            batchLines.push_back(lineNumber);
         } else {
             qDebug() << "Ошибка парсинга строки" << lineNumber << ":" << line;
         }
     }
 
+    auto statuses = hashTable.bulkInsert(std::move(batch));
+
+    int loaded = 0;
+    for (std::size_t i = 0; i < statuses.size(); ++i) {
+        switch (statuses[i]) {
+        case HashTable::InsertStatus::Inserted:
+            loaded++;
+            break;
+        case HashTable::InsertStatus::Duplicate:
+            qDebug() << "Строка" << batchLines[i] << ": пациент с таким полисом уже есть";
+            break;
+        case HashTable::InsertStatus::DuplicateInBatch:
+            qDebug() << "Строка" << batchLines[i] << ": полис повторяется в файле";
+            break;
+        case HashTable::InsertStatus::Invalid:
+            qDebug() << "Строка" << batchLines[i] << ": некорректный полис";
+            break;
+        }
+    }
+
     file.close();
+    hashTable.dumpStatistics();
     updateAllTables();
 
     QMessageBox::information(this, "Загрузка завершена",
@@ -796,6 +870,7 @@ void MainWindow::loadAppointmentsFromFile() {
     int loaded = 0;
     int skipped = 0;
     int lineNumber = 0;
+    const std::size_t firstLoaded = AppointmentArray.Size();
 
     while (!in.atEnd()) {
         QString line = in.readLine().trimmed();
@@ -803,24 +878,26 @@ void MainWindow::loadAppointmentsFromFile() {
 
         if (line.isEmpty()) continue;
 
-        std::string policy;
+        PolicyId policy;
         Appointment appointment;
+        QString doctor, diagnosis;
 
-        if (parseAppointmentLine(line, policy, appointment)) {
+        if (parseAppointmentLine(line, policy, appointment, doctor, diagnosis)) {
             if (!patientExists(policy)) {
                 qDebug() << "Строка" << lineNumber << ": Пациент с полисом"
-                         << QString::fromStdString(policy) << "не найден. Пропускаем приём.";
+                         << policyToQString(policy) << "не найден. Пропускаем приём.";
                 skipped++;
                 continue;
             }
 
-            if (avlTree.insert(policy, appointment, AppointmentArray)) {
-                appointmentPolicies.push_back(policy);
-                loaded++;
-            } else {
-                qDebug() << "Ошибка вставки приёма на строке" << lineNumber;
-                skipped++;
-            }
+            // В словари попадают только значения принятых строк
+            appointment.doctorId = DoctorTypes.intern(doctor.toStdString());
+            appointment.diagnosisId = Diagnoses.intern(diagnosis.toStdString());
+
+            // Приём только дописывается в хранилище: деревья
+            // индексируются один раз после чтения всего файла
+            AppointmentArray.Add(appointment);
+            loaded++;
         } else {
             qDebug() << "Ошибка парсинга строки" << lineNumber << ":" << line;
             skipped++;
@@ -829,13 +906,22 @@ void MainWindow::loadAppointmentsFromFile() {
 
     file.close();
 
+    // В пустое хранилище деревья собираются целиком из упорядоченных
+    // пар; к уже загруженным приёмам новые добавляются по одному
+    if (loaded > 0 && firstLoaded == 0) {
+        rebuildAppointmentIndexes();
+    } else {
+        for (std::size_t i = firstLoaded; i < AppointmentArray.Size(); ++i) {
+            avlTree.insertIndex(AppointmentArray.policy(i), i);
+            dateTree.insertIndex(AppointmentArray.date(i), i);
+            dateDoctorTree.insertIndex({AppointmentArray.date(i), AppointmentArray.doctor(i)}, i);
+        }
+    }
+
     // ИСПРАВЛЕНИЕ: Сначала обновляем таблицы (БЕЗ дерева)
     updateAllTables();
 
-    // Затем строим дерево дат ОДИН раз
     if (loaded > 0) {
-        buildDateTreeForReport();
-
         // Переключаемся на дерево дат
         currentTreeType = CurrentTreeType::DateTree;
         showPolicyTreeAction->setEnabled(true);
@@ -854,14 +940,13 @@ void MainWindow::loadAppointmentsFromFile() {
     QMessageBox::information(this, "Загрузка завершена", message);
 }
 
-bool MainWindow::parsePatientLine(const QString& line, std::string& policy, Patient& patient) {
+bool MainWindow::parsePatientLine(const QString& line, PolicyId& policy, Patient& patient) {
     // Новый формат: 1234 5678 9012 3456 Иванов Иван Иванович 12 янв 1990
     QStringList parts = line.split(" ", Qt::SkipEmptyParts);
     if (parts.size() != 10) return false;
 
     // Полис = первые 4 части
-    QString policyStr = parts[0] + parts[1] + parts[2] + parts[3];
-    policy = policyStr.toStdString();
+    if (!parseLinePolicy(line, policy)) return false;
 
     // ФИО
     patient.surname = parts[4].toStdString();
@@ -881,7 +966,10 @@ bool MainWindow::parsePatientLine(const QString& line, std::string& policy, Pati
 }
 
 
-bool MainWindow::parseAppointmentLine(const QString& line, std::string& policy, Appointment& appointment) {
+// Разбирает строку файла приёмов. Врач и диагноз возвращаются текстом:
+// в словари их заносит загрузчик, когда строка принята
+bool MainWindow::parseAppointmentLine(const QString& line, PolicyId& policy, Appointment& appointment,
+                                      QString& doctor, QString& diagnosis) {
     QStringList parts = line.split(" ", Qt::SkipEmptyParts);
 
     // Минимум должно быть 8 частей: 4 (полис) + 1 (диагноз) + 1 (врач) + 1 (день) + 1 (месяц) + 1 (год)
@@ -892,8 +980,10 @@ bool MainWindow::parseAppointmentLine(const QString& line, std::string& policy,
     }
 
     // Полис (первые 4 части)
-    QString policyStr = parts[0] + parts[1] + parts[2] + parts[3];
-    policy = policyStr.toStdString();
+    if (!parseLinePolicy(line, policy)) {
+        qDebug() << "Некорректный полис в строке:" << line;
+        return false;
+    }
 
     // Дата и месяц всегда в конце
     bool ok;
@@ -916,24 +1006,23 @@ bool MainWindow::parseAppointmentLine(const QString& line, std::string& policy,
     Month month = monthFromShortString(monthStr);
 
     // Врач - четвертый элемент с конца
-    QString doctorStr = parts[parts.size()-4];
+    doctor = parts[parts.size()-4];
 
     // Диагноз - все что между полисом и врачом
     QStringList diagnosisParts;
     for (int i = 4; i < parts.size() - 4; ++i) {
         diagnosisParts << parts[i];
     }
-    QString diagnosisStr = diagnosisParts.join(" "); // Объединяем обратно пробелами
+    diagnosis = diagnosisParts.join(" "); // Объединяем обратно пробелами
 
     // Заполняем структуру
-    appointment.doctorType = doctorStr.toStdString();
-    appointment.diagnosis = diagnosisStr.toStdString();
     appointment.appointmentDate = {day, month, year};
+    appointment.policy = policy;
 
     qDebug() << "Парсинг успешен:"
-             << "полис=" << QString::fromStdString(policy)
-             << "диагноз=" << diagnosisStr
-             << "врач=" << doctorStr
+             << "полис=" << policyToQString(policy)
+             << "диагноз=" << diagnosis
+             << "врач=" << doctor
              << "дата=" << day << monthStr << year;
 
     return true;
@@ -946,7 +1035,7 @@ void MainWindow::updatePatientTable() {
 
     for (std::size_t i = 0; i < PatientArray.Size(); ++i) {
         const Patient& patient = PatientArray[i];
-        std::string policy = hashTable.getKeyForIndex(i);
+        PolicyId policy = hashTable.getKeyForIndex(i);
 
         QString fio = QString("%1 %2 %3")
                           .arg(QString::fromStdString(patient.surname))
@@ -958,7 +1047,7 @@ void MainWindow::updatePatientTable() {
         int row = patientTable->rowCount();
         patientTable->insertRow(row);
         patientTable->setItem(row, 0, new QTableWidgetItem(fio));
-        patientTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(policy)));
+        patientTable->setItem(row, 1, new QTableWidgetItem(policyToQString(policy)));
         patientTable->setItem(row, 2, new QTableWidgetItem(birth));
     }
 }
@@ -966,12 +1055,12 @@ void MainWindow::updatePatientTable() {
 void MainWindow::updateAppointmentTable() {
     appointmentTable->setRowCount(0);
 
-    for (std::size_t i = 0; i < AppointmentArray.Size() && i < appointmentPolicies.size(); ++i) {
+    for (std::size_t i = 0; i < AppointmentArray.Size(); ++i) {
         const Appointment& app = AppointmentArray[i];
 
-        QString policy = QString::fromStdString(appointmentPolicies[i]);
-        QString diagnosis = QString::fromStdString(app.diagnosis);
-        QString doctor = QString::fromStdString(app.doctorType);
+        QString policy = policyToQString(app.policy);
+        QString diagnosis = QString::fromStdString(Diagnoses[app.diagnosisId]);
+        QString doctor = QString::fromStdString(DoctorTypes[app.doctorId]);
         QString date = formatDate(app.appointmentDate);
 
         int row = appointmentTable->rowCount();
@@ -984,6 +1073,8 @@ void MainWindow::updateAppointmentTable() {
 }
 
 void MainWindow::updateHashTableView() {
+    // Ячейки показываются по одной таблице, поэтому незавершённый рехэш доносится
+    hashTable.finishRehash();
     hashTableView->setRowCount(hashTable.getSize());
 
     for (std::size_t i = 0; i < hashTable.getSize(); ++i) {
@@ -1007,6 +1098,10 @@ void MainWindow::updateHashTableView() {
         case Status::Active:  status = "Active"; break;
         case Status::Deleted: status = "Deleted"; break;
         }
+        // Сдвиг записи от домашней ячейки (Robin Hood)
+        if (record.getStatus() == ::Status::Active && record.getProbeLength() > 0) {
+            status += QString(" (+%1)").arg(record.getProbeLength());
+        }
         hashTableView->setItem(i, 2, new QTableWidgetItem(status));
 
 
@@ -1057,10 +1152,10 @@ void MainWindow::addPatient() {
                                                 QLineEdit::Normal, "", &ok);
     if (!ok || policyInput.isEmpty()) return;
 
-    std::string policy = policyInput.toStdString();
+    PolicyId policy;
 
     // Проверяем формат полиса
-    if (policy.length() != 16 || !std::all_of(policy.begin(), policy.end(), ::isdigit)) {
+    if (!parsePolicy(policyInput, policy)) {
         QMessageBox::warning(this, "Ошибка", "Полис должен содержать ровно 16 цифр!");
         return;
     }
@@ -1069,7 +1164,7 @@ void MainWindow::addPatient() {
     if (hashTable.exists(policy)) {
         QMessageBox::warning(this, "Ошибка",
                              QString("Пациент с полисом %1 уже существует!")
-                                 .arg(QString::fromStdString(policy)));
+                                 .arg(policyToQString(policy)));
         return;
     }
 
@@ -1110,19 +1205,25 @@ void MainWindow::addPatient() {
     int year = QInputDialog::getInt(this, "Добавление пациента", "Год рождения:", 1990, 1900, 2100, 1, &ok);
     if (!ok) return;
 
-    // Формируем строку ФИО для передачи в хэш-таблицу
     QString fullName = QString("%1 %2 %3").arg(surname).arg(name).arg(middlename);
 
     try {
         Month birthMonth = monthFromShortString(monthStr);
+        Patient patient{name.toStdString(), surname.toStdString(), middlename.toStdString(),
+                        Date{day, birthMonth, year}};
 
-        // Добавляем пациента через хэш-таблицу
-        if (hashTable.insert(policy, fullName.toStdString(), day, birthMonth, year)) {
+        // Вставка одним проходом: если полис появился, пока открыты диалоги,
+        // tryEmplace вернёт false вместо повторной проверки exists
+        if (hashTable.tryEmplace(policy, std::move(patient)).second) {
             updateAllTables();
             QMessageBox::information(this, "Успех",
                                      QString("Пациент %1 с полисом %2 добавлен!")
                                          .arg(fullName)
-                                         .arg(QString::fromStdString(policy)));
+                                         .arg(policyToQString(policy)));
+        } else {
+            QMessageBox::warning(this, "Ошибка",
+                                 QString("Пациент с полисом %1 уже существует!")
+                                     .arg(policyToQString(policy)));
         }
     } catch (const std::exception& e) {
         QMessageBox::warning(this, "Ошибка",
@@ -1139,10 +1240,10 @@ void MainWindow::addAppointment() {
                                                 QLineEdit::Normal, "", &ok);
     if (!ok || policyInput.isEmpty()) return;
 
-    std::string policy = policyInput.toStdString();
+    PolicyId policy;
 
     // Проверяем формат полиса
-    if (policy.length() != 16 || !std::all_of(policy.begin(), policy.end(), ::isdigit)) {
+    if (!parsePolicy(policyInput, policy)) {
         QMessageBox::warning(this, "Ошибка", "Полис должен содержать ровно 16 цифр!");
         return;
     }
@@ -1170,49 +1271,38 @@ void MainWindow::addAppointment() {
     int year = QInputDialog::getInt(this, "Добавление приёма", "Год:", 2024, 1900, 2100, 1, &ok);
     if (!ok) return;
 
-    // Создаём объект приёма
+    // Создаём объект приёма. Врача пока только ищем в словаре: нового
+    // врача ещё нет ни в одном приёме, а в словарь значения попадают
+    // только после проверки
+    const std::string doctorText = doctorType.toStdString();
+    const std::string diagnosisText = diagnosis.toStdString();
     Appointment appointment;
-    appointment.doctorType = doctorType.toStdString();
-    appointment.diagnosis = diagnosis.toStdString();
+    appointment.doctorId = DoctorTypes.find(doctorText);
     appointment.appointmentDate.day = day;
     appointment.appointmentDate.month = monthFromShortString(monthStr);
     appointment.appointmentDate.year = year;
+    appointment.policy = policy;
 
     // ПРОВЕРКА РЕФЕРЕНЦИАЛЬНОЙ ЦЕЛОСТНОСТИ
-    if (!validateAppointmentData(policy, appointment)) {
+    if (!validateAppointmentData(policy, appointment, doctorText, diagnosisText)) {
         return; // Валидация не прошла
     }
 
-    // Добавляем приём
-    if (avlTree.insert(policy, appointment, AppointmentArray)) {
-        appointmentPolicies.push_back(policy);
-        updateAllTables();
+    appointment.doctorId = DoctorTypes.intern(doctorText);
+    appointment.diagnosisId = Diagnoses.intern(diagnosisText);
 
-        QMessageBox::information(this, "Успех",
-                                 QString("Приём для пациента с полисом %1 добавлен!")
-                                     .arg(QString::fromStdString(policy)));
-    } else {
-        QMessageBox::warning(this, "Ошибка", "Не удалось добавить приём!");
-    }
+    // Добавляем приём: запись в хранилище и в оба дерева
+    addAppointmentRecord(appointment);
 
-    if (avlTree.insert(policy, appointment, AppointmentArray)) {
-        appointmentPolicies.push_back(policy);
-
-        // ИСПРАВЛЕНИЕ: Сначала таблицы (БЕЗ дерева)
-        updateAllTables();
-
-        // Затем дерево дат ОДИН раз
-        buildDateTreeForReport();
+    // ИСПРАВЛЕНИЕ: Сначала таблицы (БЕЗ дерева)
+    updateAllTables();
 
-        // Обновляем только текущее дерево ОДИН раз
-        updateCurrentTree();
+    // Обновляем только текущее дерево ОДИН раз
+    updateCurrentTree();
 
-        QMessageBox::information(this, "Успех",
-                                 QString("Приём для пациента с полисом %1 добавлен!")
-                                     .arg(QString::fromStdString(policy)));
-    } else {
-        QMessageBox::warning(this, "Ошибка", "Не удалось добавить приём!");
-    }
+    QMessageBox::information(this, "Успех",
+                             QString("Приём для пациента с полисом %1 добавлен!")
+                                 .arg(policyToQString(policy)));
 }
 
 
@@ -1223,13 +1313,18 @@ void MainWindow::deletePatient() {
                                                 QLineEdit::Normal, "", &ok);
     if (!ok || policyInput.isEmpty()) return;
 
-    std::string policy = policyInput.toStdString();
+    PolicyId policy;
+    if (!parsePolicy(policyInput, policy)) {
+        QMessageBox::warning(this, "Ошибка", "Полис должен содержать ровно 16 цифр!");
+        return;
+    }
 
-    // Проверяем существование пациента
-    if (!patientExists(policy)) {
+    // Ищем пациента один раз: ссылка на запись нужна и для удаления
+    auto patient = hashTable.find(policy);
+    if (!patient) {
         QMessageBox::warning(this, "Ошибка",
                              QString("Пациент с полисом %1 не найден!")
-                                 .arg(QString::fromStdString(policy)));
+                                 .arg(policyToQString(policy)));
         return;
     }
 
@@ -1237,7 +1332,7 @@ void MainWindow::deletePatient() {
     int ret = QMessageBox::question(this, "Подтверждение удаления",
                                     QString("Вы уверены, что хотите удалить пациента с полисом %1?\n\n"
                                             "ВНИМАНИЕ: Будут удалены ВСЕ приёмы этого пациента!")
-                                        .arg(QString::fromStdString(policy)),
+                                        .arg(policyToQString(policy)),
                                     QMessageBox::Yes | QMessageBox::No);
 
     if (ret != QMessageBox::Yes) return;
@@ -1245,12 +1340,12 @@ void MainWindow::deletePatient() {
     // КАСКАДНОЕ УДАЛЕНИЕ: сначала удаляем все приёмы пациента
     deleteAllAppointmentsForPatient(policy);
 
-    // Затем удаляем самого пациента
-    if (hashTable.remove(policy)) {
+    // Затем удаляем самого пациента — по найденной ссылке, без повторного поиска
+    if (hashTable.extract(patient)) {
         updateAllTables();
         QMessageBox::information(this, "Успех",
                                  QString("Пациент с полисом %1 и все его приёмы удалены!")
-                                     .arg(QString::fromStdString(policy)));
+                                     .arg(policyToQString(policy)));
     } else {
         QMessageBox::warning(this, "Ошибка", "Не удалось удалить пациента!");
     }
@@ -1263,7 +1358,11 @@ void MainWindow::deleteAppointment() {
                                                 QLineEdit::Normal, "", &ok);
     if (!ok || policyInput.isEmpty()) return;
 
-    std::string policy = policyInput.toStdString();
+    PolicyId policy;
+    if (!parsePolicy(policyInput, policy)) {
+        QMessageBox::warning(this, "Ошибка", "Полис должен содержать ровно 16 цифр!");
+        return;
+    }
 
     QString doctorType = QInputDialog::getText(this, "Удаление приёма",
                                                "Введите тип врача:",
@@ -1288,22 +1387,28 @@ void MainWindow::deleteAppointment() {
     int year = QInputDialog::getInt(this, "Удаление приёма", "Год:", 2024, 1900, 2100, 1, &ok);
     if (!ok) return;
 
-    // Создаём объект приёма для поиска
+    // Создаём объект приёма для поиска: неизвестные врач или диагноз
+    // означают, что такого приёма точно нет
     Appointment appointment;
-    appointment.doctorType = doctorType.toStdString();
-    appointment.diagnosis = diagnosis.toStdString();
+    appointment.doctorId = DoctorTypes.find(utf16Of(doctorType));
+    appointment.diagnosisId = Diagnoses.find(utf16Of(diagnosis));
+    if (appointment.doctorId == StringDictionary::npos || appointment.diagnosisId == StringDictionary::npos) {
+        QMessageBox::warning(this, "Ошибка", "Приём не найден или не удалось удалить!");
+        return;
+    }
     appointment.appointmentDate.day = day;
     appointment.appointmentDate.month = monthFromShortString(monthStr);
     appointment.appointmentDate.year = year;
+    appointment.policy = policy;
+
+    // Удаляем приём из хранилища и обоих деревьев
+    std::size_t index = findAppointmentRecord(appointment);
+    if (index != AppointmentArray.Size()) {
+        removeAppointmentRecord(index);
 
-    // Удаляем приём из дерева
-    if (avlTree.remove(policy, appointment, AppointmentArray)) {
         // ИСПРАВЛЕНИЕ: Сначала таблицы (БЕЗ дерева)
         updateAllTables();
 
-        // Затем дерево дат ОДИН раз
-        buildDateTreeForReport();
-
         // Обновляем только текущее дерево ОДИН раз
         updateCurrentTree();
 
@@ -1322,17 +1427,17 @@ void MainWindow::debugDateTreeNodes() {
         return;
     }
 
-    std::map<std::string, std::vector<std::size_t>> dateNodes;
+    std::map<DateKey, std::vector<std::size_t>> dateNodes;
 
     // Собираем все узлы дерева
-    dateTree.traverseIndex([&](std::size_t index, const std::string& dateKey) {
+    dateTree.traverseIndex([&](std::size_t index, const DateKey& dateKey) {
         dateNodes[dateKey].push_back(index);
     });
 
     qDebug().noquote() << QString("Найдено уникальных дат: %1").arg(dateNodes.size());
 
     for (const auto& [dateKey, indices] : dateNodes) {
-        Date date = stringToDate(dateKey);
+        Date date = Date::fromKey(dateKey);
         QString displayDate = QString("%1.%2.%3")
                                   .arg(date.day, 2, 10, QChar('0'))
                                   .arg(static_cast<int>(date.month), 2, 10, QChar('0'))
@@ -1340,7 +1445,7 @@ void MainWindow::debugDateTreeNodes() {
 
         qDebug().noquote() << QString("\n📅 ДАТА: %1 (ключ: %2)")
                                   .arg(displayDate)
-                                  .arg(QString::fromStdString(dateKey));
+                                  .arg(dateKey);
         qDebug().noquote() << QString("   Приёмов: %1").arg(indices.size());
 
         // Показываем детали каждого приёма
@@ -1348,14 +1453,13 @@ void MainWindow::debugDateTreeNodes() {
             std::size_t idx = indices[i];
             if (idx < AppointmentArray.Size()) {
                 const Appointment& app = AppointmentArray[idx];
-                QString policy = (idx < appointmentPolicies.size()) ?
-                                     QString::fromStdString(appointmentPolicies[idx]) : "НЕТ_ПОЛИСА";
+                QString policy = app.policy.isValid() ? policyToQString(app.policy) : "НЕТ_ПОЛИСА";
 
                 qDebug().noquote() << QString("   %1. [%2] %3 → %4 (полис: %5)")
                                           .arg(i + 1)
                                           .arg(idx)
-                                          .arg(QString::fromStdString(app.doctorType))
-                                          .arg(QString::fromStdString(app.diagnosis))
+                                          .arg(QString::fromStdString(DoctorTypes[app.doctorId]))
+                                          .arg(QString::fromStdString(Diagnoses[app.diagnosisId]))
                                           .arg(policy);
             } else {
                 qDebug().noquote() << QString("   %1. [%2] ОШИБКА: индекс вне массива!")
@@ -1368,6 +1472,21 @@ void MainWindow::debugDateTreeNodes() {
         }
     }
 
+    // Квартили дат приёмов: выбор k-й записи по счётчикам поддеревьев, без обхода
+    const std::size_t total = dateTree.size();
+    const std::pair<const char*, std::size_t> quantiles[] = {
+        {"25%", total / 4}, {"медиана", total / 2}, {"75%", total * 3 / 4}};
+    for (const auto& [label, k] : quantiles) {
+        auto [node, pos] = dateTree.select(k);
+        if (node == dateTree.end())
+            continue;
+        qDebug().noquote() << QString("Дата приёма (%1, №%2 из %3): %4")
+                                  .arg(label)
+                                  .arg(k + 1)
+                                  .arg(total)
+                                  .arg(formatDate(Date::fromKey(node->key)));
+    }
+
     qDebug().noquote() << "=== КОНЕЦ ОТЛАДКИ УЗЛОВ ===\n";
 }
 
@@ -1388,7 +1507,8 @@ void MainWindow::saveFullReportToFile(const QString& filePath, const std::vector
     out << "ПАРАМЕТРЫ ОТЧЕТА:\n";
     out << "ФИО пациента: " << (fioFilterEdit->text().isEmpty() ? "Все" : fioFilterEdit->text()) << "\n";
     out << "Тип врача: " << (doctorFilterEdit->text().isEmpty() ? "Все" : doctorFilterEdit->text()) << "\n";
-    out << "Дата приёма: " << dateFilterEdit->date().toString("dd.MM.yyyy") << "\n\n";
+    out << "Период приёма: " << dateFilterEdit->date().toString("dd.MM.yyyy")
+        << " – " << dateToFilterEdit->date().toString("dd.MM.yyyy") << "\n\n";
 
     out << QString("РЕЗУЛЬТАТ: %1 записей\n").arg(reportData.size());
     out << QString("=").repeated(120) << "\n\n";
@@ -1412,9 +1532,9 @@ void MainWindow::saveFullReportToFile(const QString& filePath, const std::vector
     for (const auto& record : reportData) {
         out << QString("%-12s %-15s %-20s %-18s %-15s %-12s %-15s %-12s %-8d %s\n")
         .arg(formatDate(record.appointmentDate))
-            .arg(QString::fromStdString(record.doctorType))
-            .arg(QString::fromStdString(record.diagnosis))
-            .arg(QString::fromStdString(record.patientPolicy))
+            .arg(QString::fromStdString(DoctorTypes[record.doctorId]))
+            .arg(QString::fromStdString(Diagnoses[record.diagnosisId]))
+            .arg(policyToQString(record.patientPolicy))
             .arg(QString::fromStdString(record.patientSurname))
             .arg(QString::fromStdString(record.patientName))
             .arg(QString::fromStdString(record.patientMiddlename))
@@ -1459,7 +1579,7 @@ void MainWindow::showDateTreeForDebugging() {
     showDateTreeAction->setEnabled(false);
 }
 
-void MainWindow::drawTreeByPolicy(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* root) {
+void MainWindow::drawTreeByPolicy(PolicyTree::Node* root) {
     if (!root) return;
 
     int treeHeight = calculateTreeHeight(root);
@@ -1472,18 +1592,7 @@ void MainWindow::drawTreeByPolicy(AVLNode<std::string, Appointment, Array<Appoin
     drawNode(root, 0, 80, sceneWidth * 0.3, 1);
 }
 
-Date MainWindow::stringToDate(const std::string& dateStr) {
-    if (dateStr.length() != 8) {
-        return {1, Month::янв, 2000}; // Значение по умолчанию
-    }
-
-    int year = std::stoi(dateStr.substr(0, 4));
-    int month = std::stoi(dateStr.substr(4, 2));
-    int day = std::stoi(dateStr.substr(6, 2));
-
-    return {day, static_cast<Month>(month), year};
-}
-void MainWindow::drawTreeByDate(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* root) {
+void MainWindow::drawTreeByDate(DateTree::Node* root) {
     if (!root) return;
 
     int treeHeight = calculateTreeHeight(root);
@@ -1496,29 +1605,21 @@ void MainWindow::drawTreeByDate(AVLNode<std::string, Appointment, Array<Appointm
     drawDateNode(root, 0, 80, sceneWidth * 0.3, 1);
 }
 
-void MainWindow::drawDateNode(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node,
+void MainWindow::drawDateNode(DateTree::Node* node,
                               qreal x, qreal y, qreal horizontalSpacing, int level) {
     if (!node) return;
 
-    // Собираем индексы из связанного списка
-    std::vector<std::size_t> indices;
-    lNode* current = node->indexList.getHead();
-    if (current) {
-        do {
-            indices.push_back(current->arrayIndex);
-            current = current->next;
-        } while (current != node->indexList.getHead());
-    }
+    // Индексы приёмов узла
+    std::vector<std::size_t> indices(node->indexList.begin(), node->indexList.end());
 
     // Форматируем дату для отображения
-    Date date = stringToDate(node->key);
+    Date date = Date::fromKey(node->key);
     QString displayDate = QString("%1.%2.%3")
                               .arg(date.day, 2, 10, QChar('0'))
                               .arg(static_cast<int>(date.month), 2, 10, QChar('0'))
                               .arg(date.year);
 
-    // ИСПРАВЛЕНИЕ: Конвертируем std::string в QString
-    QString dateKey = QString::fromStdString(node->key);
+    QString dateKey = QString::number(node->key);
 
     // Создаем узел для дерева дат
     DateTreeNodeItem* nodeItem = new DateTreeNodeItem(displayDate, dateKey, indices, &hashTable, x, y);
@@ -1576,24 +1677,27 @@ void MainWindow::generateReport() {
     // Получаем значения фильтров
     QString fioText = fioFilterEdit->text().trimmed();
     QString doctorText = doctorFilterEdit->text().trimmed();
-    QDate qdate = dateFilterEdit->date();
+    QDate qdateFrom = dateFilterEdit->date();
+    QDate qdateTo = dateToFilterEdit->date();
+
+    if (qdateTo < qdateFrom) {
+        QMessageBox::warning(this, "Ошибка", "Конец периода раньше его начала!");
+        return;
+    }
 
     std::string fioFilter = fioText.toStdString();
     std::string doctorFilter = doctorText.toStdString();
-    Date filterDate = {qdate.day(), static_cast<Month>(qdate.month()), qdate.year()};
+    Date dateFrom = {qdateFrom.day(), static_cast<Month>(qdateFrom.month()), qdateFrom.year()};
+    Date dateTo = {qdateTo.day(), static_cast<Month>(qdateTo.month()), qdateTo.year()};
 
-    qDebug().noquote() << QString("Фильтры: ФИО='%1', Врач='%2', Дата=%3.%4.%5")
+    qDebug().noquote() << QString("Фильтры: ФИО='%1', Врач='%2', Период=%3 – %4")
                               .arg(fioText)
                               .arg(doctorText)
-                              .arg(filterDate.day)
-                              .arg(static_cast<int>(filterDate.month))
-                              .arg(filterDate.year);
-
-    // Строим дерево отчетов по дате
-    buildDateTreeForReport();
+                              .arg(qdateFrom.toString("dd.MM.yyyy"))
+                              .arg(qdateTo.toString("dd.MM.yyyy"));
 
     // Получаем полные данные с применением фильтров
-    std::vector<FullReportRecord> reportData = generateFullReportData(fioFilter, doctorFilter, filterDate);
+    std::vector<FullReportRecord> reportData = generateFullReportData(fioFilter, doctorFilter, dateFrom, dateTo);
 
     qDebug().noquote() << QString("Получено записей для отчета: %1").arg(reportData.size());
 
@@ -1604,9 +1708,9 @@ void MainWindow::generateReport() {
 
         // Заполняем все колонки полными данными
         reportTable->setItem(row, 0, new QTableWidgetItem(formatDate(record.appointmentDate)));
-        reportTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(record.doctorType)));
-        reportTable->setItem(row, 2, new QTableWidgetItem(QString::fromStdString(record.diagnosis)));
-        reportTable->setItem(row, 3, new QTableWidgetItem(QString::fromStdString(record.patientPolicy)));
+        reportTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(DoctorTypes[record.doctorId])));
+        reportTable->setItem(row, 2, new QTableWidgetItem(QString::fromStdString(Diagnoses[record.diagnosisId])));
+        reportTable->setItem(row, 3, new QTableWidgetItem(policyToQString(record.patientPolicy)));
         reportTable->setItem(row, 4, new QTableWidgetItem(QString::fromStdString(record.patientSurname)));
         reportTable->setItem(row, 5, new QTableWidgetItem(QString::fromStdString(record.patientName)));
         reportTable->setItem(row, 6, new QTableWidgetItem(QString::fromStdString(record.patientMiddlename)));
@@ -1630,9 +1734,9 @@ void MainWindow::generateReport() {
     if (reportData.empty()) {
         message = "По заданным фильтрам записи не найдены.\n\n"
                   "Проверьте:\n"
-                  "- Правильность написания ФИО (точное совпадение)\n"
+                  "- Правильность написания ФИО (регистр не важен)\n"
                   "- Правильность типа врача\n"
-                  "- Наличие приёмов на выбранную дату";
+                  "- Наличие приёмов за выбранный период";
         QMessageBox::information(this, "Результат поиска", message);
     } else {
         int validRecords = 0;
@@ -1681,18 +1785,43 @@ void MainWindow::showSplitSearchDialog() {
     QPushButton* searchPatientBtn = new QPushButton("Найти пациента");
     QObject::connect(searchPatientBtn, &QPushButton::clicked, this, [=, this]() {
         patientResult->setRowCount(0);
-        std::string policy = policyEdit1->text().trimmed().toStdString();
-        const Patient* p = hashTable.get(policy);
+        PolicyId policy;
+        const Patient* p = nullptr;
+        if (parsePolicy(policyEdit1->text(), policy))
+            p = hashTable.get(policy);
         if (!p) {
             QMessageBox::warning(this, "Ошибка", "Пациент не найден.");
             return;
         }
         patientResult->insertRow(0);
         patientResult->setItem(0, 0, new QTableWidgetItem(QString::fromStdString(p->surname + " " + p->name + " " + p->middlename)));
-        patientResult->setItem(0, 1, new QTableWidgetItem(QString::fromStdString(policy)));
+        patientResult->setItem(0, 1, new QTableWidgetItem(policyToQString(policy)));
         patientResult->setItem(0, 2, new QTableWidgetItem(formatDate(p->birthDate)));
     });
 
+    // Поиск пациентов по ФИО через индекс ФИО хэш-таблицы
+    QLineEdit* fioEdit = new QLineEdit();
+    fioEdit->setPlaceholderText("Фамилия Имя Отчество");
+
+    QPushButton* searchFioBtn = new QPushButton("Найти по ФИО");
+    QObject::connect(searchFioBtn, &QPushButton::clicked, this, [=, this]() {
+        patientResult->setRowCount(0);
+        const std::vector<PolicyId>& policies = hashTable.findByFio(utf16Of(fioEdit->text().trimmed()));
+        if (policies.empty()) {
+            QMessageBox::warning(this, "Ошибка", "Пациенты с таким ФИО не найдены.");
+            return;
+        }
+        for (PolicyId policy : policies) {
+            const Patient* p = hashTable.get(policy);
+            if (!p) continue;
+            int row = patientResult->rowCount();
+            patientResult->insertRow(row);
+            patientResult->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(p->surname + " " + p->name + " " + p->middlename)));
+            patientResult->setItem(row, 1, new QTableWidgetItem(policyToQString(policy)));
+            patientResult->setItem(row, 2, new QTableWidgetItem(formatDate(p->birthDate)));
+        }
+    });
+
     // Поле для поиска приёмов
     QLineEdit* policyEdit2 = new QLineEdit();
     policyEdit2->setPlaceholderText("Полис ОМС для приёмов");
@@ -1705,14 +1834,18 @@ void MainWindow::showSplitSearchDialog() {
     QPushButton* searchAppointmentsBtn = new QPushButton("Найти приёмы");
     QObject::connect(searchAppointmentsBtn, &QPushButton::clicked, this, [=, this]() {
         appointmentResult->setRowCount(0);
-        std::string policy = policyEdit2->text().trimmed().toStdString();
+        PolicyId policy;
+        if (!parsePolicy(policyEdit2->text(), policy)) {
+            QMessageBox::warning(this, "Ошибка", "Полис должен содержать ровно 16 цифр!");
+            return;
+        }
         avlTree.traverseByKey(policy, [&](std::size_t index) {
             if (index >= AppointmentArray.Size()) return;
             const Appointment& a = AppointmentArray[index];
             int row = appointmentResult->rowCount();
             appointmentResult->insertRow(row);
-            appointmentResult->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(a.diagnosis)));
-            appointmentResult->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(a.doctorType)));
+            appointmentResult->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(Diagnoses[a.diagnosisId])));
+            appointmentResult->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(DoctorTypes[a.doctorId])));
             appointmentResult->setItem(row, 2, new QTableWidgetItem(formatDate(a.appointmentDate)));
             appointmentResult->setItem(row, 3, new QTableWidgetItem(QString::number(index)));
         });
@@ -1721,6 +1854,8 @@ void MainWindow::showSplitSearchDialog() {
     // Добавим в макет
     layout->addWidget(policyEdit1);
     layout->addWidget(searchPatientBtn);
+    layout->addWidget(fioEdit);
+    layout->addWidget(searchFioBtn);
     layout->addWidget(patientResult);
     layout->addSpacing(10);
     layout->addWidget(policyEdit2);
@@ -1735,32 +1870,15 @@ void MainWindow::showSplitSearchDialog() {
 
 
 void MainWindow::showDebugWindow() {
-    // Базовая статистика
+    // Базовая статистика (счётчики хэш-таблицы ведутся на ходу — без прохода по ячейкам)
     auto hashStats = hashTable.getStatistics();
     auto treeStats = avlTree.getStatistics();
 
-    // Анализ коллизий в хэш-таблице
-    int collisions = 0;
-    int maxChainLength = 0;
-    int emptySlots = 0;
-
-    std::vector<int> chainLengths(hashTable.getSize(), 0);
-
-    for (std::size_t i = 0; i < hashTable.getSize(); ++i) {
-        const HashRecord& record = hashTable.getRecord(i);
-        if (record.getStatus() == ::Status::Active) {  // ИСПРАВЛЕНО
-            // Вычисляем, где должен был бы находиться элемент изначально
-            std::size_t idealPos = hashTable.getHashValue(record.key);
-            if (idealPos != i) {
-                collisions++;
-            }
-        } else {
-            emptySlots++;
-        }
-    }
+    // Коллизии — записи, лежащие не в своей домашней ячейке
+    std::size_t collisions = hashStats.displaced;
 
     // Статистика AVL-дерева
-    std::vector<std::string> treeKeys = avlTree.getAllKeys();
+    std::vector<PolicyId> treeKeys = avlTree.getAllKeys();
     int totalAppointments = 0;
     int maxAppointmentsPerPolicy = 0;
     int minAppointmentsPerPolicy = INT_MAX;
@@ -1840,6 +1958,23 @@ void MainWindow::showDebugWindow() {
                         .arg(PatientArray.Size() >= treeKeys.size() ? "✓" : "⚠️")  // 26
         ;
 
+    debug += QString("\n\nКАЧЕСТВО ХЭШИРОВАНИЯ:\n"
+                     "• Средний проб (успешный поиск): %1\n"
+                     "• Средний проб (неуспешный поиск): %2\n"
+                     "• Максимальный проб: %3\n"
+                     "• Длиннейший кластер занятых ячеек: %4\n"
+                     "• Удалённые метки: %5\n"
+                     "• Распределение проб:")
+                 .arg(hashStats.avgSuccessfulProbe, 0, 'f', 2)
+                 .arg(QString::number(hashStats.avgUnsuccessfulProbe, 'f', 2)
+                      + (hashStats.probeByGroups ? QString(" (групп по 16 ячеек)") : QString()))
+                 .arg(hashStats.maxProbeLength)
+                 .arg(hashStats.longestCluster)
+                 .arg(hashStats.tombstones);
+    for (std::size_t d = 0; d <= hashStats.maxProbeLength && hashStats.usedSlots > 0; ++d) {
+        debug += QString("\n    %1: %2").arg(d, 2).arg(hashStats.probeHistogram[d]);
+    }
+
     // Создаем диалог с прокруткой для большого текста
     QDialog* debugDialog = new QDialog(this);
     debugDialog->setWindowTitle("Подробная диагностика");
@@ -1861,18 +1996,21 @@ void MainWindow::showDebugWindow() {
     debugDialog->deleteLater();
 }
 
-bool MainWindow::validateAppointmentData(const std::string& policy, const Appointment& appointment) {
+// Проверка приёма до записи. doctorId может быть npos (врача ещё нет
+// в словаре), diagnosisId не используется: значения проверяются по тексту
+bool MainWindow::validateAppointmentData(PolicyId policy, const Appointment& appointment,
+                                         const std::string& doctor, const std::string& diagnosis) {
     // Проверяем существование пациента
     if (!patientExists(policy)) {
         QMessageBox::warning(this, "Ошибка валидации",
                              QString("Пациент с полисом %1 не найден в системе!\n"
                                      "Сначала добавьте пациента.")
-                                 .arg(QString::fromStdString(policy)));
+                                 .arg(policyToQString(policy)));
         return false;
     }
 
     // Дополнительные проверки данных приёма
-    if (!isValidStringField(appointment.doctorType) || !isValidStringField(appointment.diagnosis)) {
+    if (!isValidStringField(doctor) || !isValidStringField(diagnosis)) {
         QMessageBox::warning(this, "Ошибка валидации",
                              "Тип врача и диагноз должны содержать минимум 2 буквы и не содержать цифр или других символов!");
         return false;
@@ -1892,7 +2030,7 @@ bool MainWindow::validateAppointmentData(const std::string& policy, const Appoin
 
         const Appointment& existing = AppointmentArray[index];
 
-        if (existing.doctorType == appointment.doctorType &&
+        if (existing.doctorId == appointment.doctorId &&
             existing.appointmentDate == appointment.appointmentDate) {
             duplicate = true;
         }
@@ -1914,41 +2052,40 @@ void MainWindow::checkReferentialIntegrity() {
     qDebug().noquote() << "=== ПРОВЕРКА РЕФЕРЕНЦИАЛЬНОЙ ЦЕЛОСТНОСТИ ===";
 
     // Получаем все полисы из хэш-таблицы (пациенты)
-    std::vector<std::string> patientPolicies = hashTable.getAllPolicies();
+    std::vector<PolicyId> patientPolicies = hashTable.getAllPolicies();
 
-    // Получаем все полисы из AVL-дерева (приёмы)
-    std::vector<std::string> appointmentPolicies = avlTree.getAllKeys();
+    // Полисы из AVL-дерева (приёмы)
+    const int appointmentPolicies = avlTree.getStatistics().uniqueKeys;
 
-    // Проверяем, есть ли приёмы без пациентов
-    std::vector<std::string> orphanedAppointments;
-    for (const auto& policy : appointmentPolicies) {
-        if (!hashTable.exists(policy)) {
-            orphanedAppointments.push_back(policy);
-        }
-    }
+    // Приёмы без пациентов ищутся параллельным обходом дерева полисов;
+    // список собирается по возрастанию полиса
+    std::vector<PolicyId> orphanedAppointments = avlTree.parallelTraverse<std::vector<PolicyId>>(
+        [this](const PolicyTree::Node& node, std::vector<PolicyId>& part) {
+            if (!node.indexList.empty() && !hashTable.exists(node.key)) {
+                part.push_back(node.key);
+            }
+        },
+        [](std::vector<PolicyId>& into, std::vector<PolicyId>&& part) {
+            into.insert(into.end(), part.begin(), part.end());
+        });
 
     qDebug().noquote() << QString("Пациентов в системе: %1").arg(patientPolicies.size());
-    qDebug().noquote() << QString("Уникальных полисов с приёмами: %1").arg(appointmentPolicies.size());
+    qDebug().noquote() << QString("Уникальных полисов с приёмами: %1").arg(appointmentPolicies);
     qDebug().noquote() << QString("Приёмов без пациентов (нарушение целостности): %1")
                               .arg(orphanedAppointments.size());
 
     if (!orphanedAppointments.empty()) {
         qDebug().noquote() << "Проблемные полисы:";
         for (const auto& policy : orphanedAppointments) {
-            qDebug().noquote() << QString("  - %1").arg(QString::fromStdString(policy));
+            qDebug().noquote() << QString("  - %1").arg(policyToQString(policy));
         }
     }
 }
 
 
 bool MainWindow::isValidPolicy(const std::string& policy) const {
-    if (policy.length() != 16) return false;
-
-    for (char c : policy) {
-        if (!std::isdigit(c)) return false;
-    }
-
-    return true;
+    PolicyId parsed;
+    return PolicyId::parse(policy, parsed);
 }
 
 void MainWindow::generateIntegrityReport() {
@@ -2007,20 +2144,13 @@ void MainWindow::updateAVLTreeTableView() {
     qDebug().noquote() << "[updateAVLTreeTableView] Начинаем обновление таблицы AVL-дерева";
 
     // Создаем структуру для хранения уникальных записей по полисам
-    std::map<std::string, std::vector<std::pair<Appointment, std::size_t>>> policyData;
-
-    // Сначала собираем все данные
-    avlTree.traverse([&policyData](const Appointment& appointment, const std::string& policy) {
-        // Находим индекс записи в массиве
-        std::size_t arrayIndex = 0;
-        for (std::size_t i = 0; i < AppointmentArray.Size(); ++i) {
-            if (AppointmentArray[i] == appointment) {
-                arrayIndex = i;
-                break;
-            }
-        }
-        policyData[policy].push_back(std::make_pair(appointment, arrayIndex));
-    }, AppointmentArray);
+    std::map<PolicyId, std::vector<std::pair<Appointment, std::size_t>>> policyData;
+
+    // Сначала собираем все данные: индекс записи берём прямо из дерева
+    avlTree.traverseIndex([&policyData](std::size_t arrayIndex, const PolicyId& policy) {
+        if (arrayIndex >= AppointmentArray.Size()) return;
+        policyData[policy].push_back(std::make_pair(AppointmentArray[arrayIndex], arrayIndex));
+    });
 
     // Теперь заполняем таблицу
     for (const auto& [policy, appointments] : policyData) {
@@ -2038,8 +2168,8 @@ void MainWindow::updateAVLTreeTableView() {
 
         // Цвет для группировки по полисам
         QColor rowColor;
-        std::hash<std::string> hasher;
-        std::size_t hash = hasher(policy);
+        std::hash<std::uint64_t> hasher;
+        std::size_t hash = hasher(policy.value);
         int colorIndex = hash % 6;
 
         switch (colorIndex) {
@@ -2057,10 +2187,10 @@ void MainWindow::updateAVLTreeTableView() {
             avlTreeTableView->insertRow(row);
 
             // Создаем элементы таблицы с явным текстом и цветом
-            QTableWidgetItem* policyItem = new QTableWidgetItem(QString::fromStdString(policy));
+            QTableWidgetItem* policyItem = new QTableWidgetItem(policyToQString(policy));
             QTableWidgetItem* countItem = new QTableWidgetItem(QString::number(appointmentCount));
-            QTableWidgetItem* doctorItem = new QTableWidgetItem(QString::fromStdString(appointment.doctorType));
-            QTableWidgetItem* diagnosisItem = new QTableWidgetItem(QString::fromStdString(appointment.diagnosis));
+            QTableWidgetItem* doctorItem = new QTableWidgetItem(QString::fromStdString(DoctorTypes[appointment.doctorId]));
+            QTableWidgetItem* diagnosisItem = new QTableWidgetItem(QString::fromStdString(Diagnoses[appointment.diagnosisId]));
             QTableWidgetItem* dateItem = new QTableWidgetItem(formatDate(appointment.appointmentDate));
             QTableWidgetItem* indexItem = new QTableWidgetItem(QString::number(arrayIndex));
 
@@ -2094,38 +2224,71 @@ void MainWindow::updateAVLTreeTableView() {
                               .arg(avlTreeTableView->rowCount());
 }
 
-bool MainWindow::patientExists(const std::string& policy) const {
+bool MainWindow::patientExists(PolicyId policy) const {
     const Patient* patient = hashTable.get(policy);
     return patient != nullptr;
 }
 
 
-void MainWindow::deleteAllAppointmentsForPatient(const std::string& policy) {
+void MainWindow::deleteAllAppointmentsForPatient(PolicyId policy) {
     qDebug().noquote() << QString("=== КАСКАДНОЕ УДАЛЕНИЕ приёмов для полиса: %1 ===")
-                              .arg(QString::fromStdString(policy));
-
-    // Удаляем все приёмы с данным полисом из AVL-дерева
-    if (avlTree.removeAllByKey(policy)) {
-        qDebug().noquote() << "→ Все приёмы удалены из дерева";
-
-        // Также нужно удалить соответствующие элементы из вектора appointmentPolicies
-        auto it = appointmentPolicies.begin();
-        while (it != appointmentPolicies.end()) {
-            if (*it == policy) {
-                it = appointmentPolicies.erase(it);
-                qDebug().noquote() << "→ Удалён полис из вектора";
-            } else {
-                ++it;
-            }
-        }
+                              .arg(policyToQString(policy));
 
-        // ИСПРАВЛЕНИЕ: Перестраиваем дерево дат после удаления
-        buildDateTreeForReport();
+    // Приёмы удаляются с конца списка узла: остальные его индексы не сдвигаются,
+    // а перенос последней записи хранилища деревья правят по обратным ссылкам
+    int removed = 0;
+    for (auto node = avlTree.find(policy); node != avlTree.end(); node = avlTree.find(policy)) {
+        removeAppointmentRecord(node->indexList.back());
+        ++removed;
+    }
+
+    if (removed > 0) {
+        qDebug().noquote() << QString("→ Удалено приёмов из деревьев и хранилища: %1").arg(removed);
     } else {
         qDebug().noquote() << "→ Приёмы с данным полисом не найдены";
     }
 }
 
+std::size_t MainWindow::addAppointmentRecord(const Appointment& appointment) {
+    AppointmentArray.Add(appointment);
+    std::size_t index = AppointmentArray.Size() - 1;
+
+    avlTree.insertIndex(appointment.policy, index);
+    dateTree.insertIndex(appointment.appointmentDate.toKey(), index);
+    dateDoctorTree.insertIndex({appointment.appointmentDate.toKey(), appointment.doctorId}, index);
+    return index;
+}
+
+void MainWindow::removeAppointmentRecord(std::size_t index) {
+    avlTree.removeIndex(index);
+    dateTree.removeIndex(index);
+    dateDoctorTree.removeIndex(index);
+
+    FixIndexFanOut<PolicyTree, DateTree, DateDoctorTree> indexes{{avlTree, dateTree, dateDoctorTree}};
+    AppointmentArray.Remove(index, indexes);
+
+    // Последний приём удалён: деревья пусты, память их арен можно вернуть
+    if (AppointmentArray.Size() == 0) {
+        avlTree.release();
+        dateTree.release();
+        dateDoctorTree.release();
+    }
+}
+
+// Индекс приёма в хранилище; AppointmentArray.Size(), если такого нет.
+// Кандидаты — только приёмы пациента из узла дерева ОМС
+std::size_t MainWindow::findAppointmentRecord(const Appointment& appointment) const {
+    auto node = avlTree.find(appointment.policy);
+    if (node == avlTree.end())
+        return AppointmentArray.Size();
+
+    for (std::size_t index : node->indexList) {
+        if (AppointmentArray[index] == appointment)
+            return index;
+    }
+    return AppointmentArray.Size();
+}
+
 
 
 void MainWindow::clearTreeVisualization()
@@ -2161,42 +2324,37 @@ void MainWindow::drawTree()
 }
 
 // Вспомогательные методы для расчета размеров дерева:
-int MainWindow::calculateTreeHeight(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node)
+template<typename NodeType>
+int MainWindow::calculateTreeHeight(NodeType* node)
 {
     if (!node) return 0;
     return 1 + std::max(calculateTreeHeight(node->left), calculateTreeHeight(node->right));
 }
 
-int MainWindow::calculateTreeWidth(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node)
+template<typename NodeType>
+int MainWindow::calculateTreeWidth(NodeType* node)
 {
     if (!node) return 0;
     return 1 + calculateTreeWidth(node->left) + calculateTreeWidth(node->right);
 }
 
-void MainWindow::drawNode(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node,
+void MainWindow::drawNode(PolicyTree::Node* node,
                           qreal x, qreal y, qreal horizontalSpacing, int level)
 {
     if (!node) return;
 
-    // Собираем индексы из связанного списка
-    std::vector<std::size_t> indices;
-    lNode* current = node->indexList.getHead();
-    if (current) {
-        do {
-            indices.push_back(current->arrayIndex);
-            current = current->next;
-        } while (current != node->indexList.getHead());
-    }
+    // Индексы приёмов узла
+    std::vector<std::size_t> indices(node->indexList.begin(), node->indexList.end());
 
     // Создаем визуальный узел
-    QString keyText = QString::fromStdString(node->key);
+    QString keyText = policyToQString(node->key);
 
     // Укорачиваем полис для отображения (показываем только последние 4 цифры)
     if (keyText.length() > 8) {
         keyText = "..." + keyText.right(4);
     }
 
-    TreeNodeItem* nodeItem = new TreeNodeItem(QString::fromStdString(node->key), indices, &hashTable, x, y);
+    TreeNodeItem* nodeItem = new TreeNodeItem(node->key, indices, &hashTable, x, y);
     treeScene->addItem(nodeItem);
     treeNodes.push_back(nodeItem);
 
@@ -2225,153 +2383,154 @@ void MainWindow::drawNode(AVLNode<std::string, Appointment, Array<Appointment, 1
     }
 }
 
-std::string MainWindow::dateToString(const Date& date) {
-    return QString("%1%2%3")
-    .arg(date.year, 4, 10, QChar('0'))
-        .arg(static_cast<int>(date.month), 2, 10, QChar('0'))
-        .arg(date.day, 2, 10, QChar('0'))
-        .toStdString();
-}
-
-void MainWindow::buildDateTreeForReport() {
-    qDebug().noquote() << "=== ПОСТРОЕНИЕ ДЕРЕВА ПО ДАТАМ ===";
-
-    // Всегда очищаем дерево перед построением
-    dateTree.clear();
-
-    if (AppointmentArray.Size() == 0) {
-        qDebug().noquote() << "→ Нет приёмов для построения дерева дат";
-        return;
-    }
-
-    int addedCount = 0;
-    std::set<std::string> uniqueDates;  // Для подсчета уникальных дат
-
-    for (std::size_t i = 0; i < AppointmentArray.Size(); ++i) {
-        const Appointment& appointment = AppointmentArray[i];
-        std::string dateKey = dateToString(appointment.appointmentDate);
-
-        uniqueDates.insert(dateKey);
-
-        if (dateTree.insertIndex(dateKey, i)) {
-            addedCount++;
-            qDebug().noquote() << QString("→ [%1] %2: %3 у %4")
-                                      .arg(i)
-                                      .arg(QString::fromStdString(dateKey))
-                                      .arg(QString::fromStdString(appointment.diagnosis))
-                                      .arg(QString::fromStdString(appointment.doctorType));
-        } else {
-            qDebug().noquote() << QString("✗ Ошибка добавления индекса %1 для даты %2")
-                                      .arg(i)
-                                      .arg(QString::fromStdString(dateKey));
-        }
-    }
-
-    qDebug().noquote() << QString("Результат: %1 приёмов добавлено, %2 уникальных дат")
-                              .arg(addedCount)
-                              .arg(uniqueDates.size());
-
-    auto root = dateTree.getRoot();
-    if (root) {
-        qDebug().noquote() << "✓ Корень дерева дат создан";
-    } else {
-        qDebug().noquote() << "✗ КРИТИЧЕСКАЯ ОШИБКА: Корень дерева дат НЕ создан!";
-    }
+// Полная сборка деревьев приёмов по хранилищу — только для пакетной загрузки
+// в пустое хранилище; остальные изменения правят деревья по одному приёму
+void MainWindow::rebuildAppointmentIndexes() {
+    qDebug().noquote() << "=== ПОСТРОЕНИЕ ДЕРЕВЬЕВ ПРИЁМОВ ===";
+
+    // Ключи читаются прямо из колонок хранилища; деревья собираются
+    // из упорядоченных пар за один проход, без поочерёдных вставок
+    avlTree.buildFromSorted(sortedAppointmentKeys<PolicyId>([](std::size_t i) { return AppointmentArray.policy(i); }));
+    dateTree.buildFromSorted(sortedAppointmentKeys<DateKey>([](std::size_t i) { return AppointmentArray.date(i); }));
+    dateDoctorTree.buildFromSorted(sortedAppointmentKeys<DateDoctorKey>([](std::size_t i) {
+        return DateDoctorKey{AppointmentArray.date(i), AppointmentArray.doctor(i)};
+    }));
+
+    qDebug().noquote() << QString("Результат: %1 приёмов, %2 полисов, %3 уникальных дат")
+                              .arg(AppointmentArray.Size())
+                              .arg(avlTree.getStatistics().totalNodes)
+                              .arg(dateTree.getStatistics().totalNodes);
 }
 
 std::vector<MainWindow::FullReportRecord> MainWindow::generateFullReportData(
     const std::string& fioFilter,
     const std::string& doctorFilter,
-    const Date& dateFilter) {
+    const Date& dateFrom,
+    const Date& dateTo) {
 
     std::vector<FullReportRecord> results;
-    std::string dateKey = dateToString(dateFilter);
-
-    qDebug().noquote() << QString("Поиск в дереве отчетов по дате: %1")
-                              .arg(QString::fromStdString(dateKey));
+    const DateKey fromKey = dateFrom.toKey();
+    const DateKey toKey = dateTo.toKey();
 
-    // Поиск по дереву дат
-    dateTree.traverseFiltered(
-        [&](const Appointment& appointment) -> bool {
-            // Фильтр по дате (должен совпадать с ключом)
-            if (dateToString(appointment.appointmentDate) != dateKey) {
-                return false;
-            }
+    // Фильтр по врачу сравнивается по номеру в словаре
+    const DictId doctorId = doctorFilter.empty() ? StringDictionary::npos : DoctorTypes.find(doctorFilter);
+    if (!doctorFilter.empty() && doctorId == StringDictionary::npos) {
+        qDebug().noquote() << QString("Врач \"%1\" не встречается ни в одном приёме")
+                                  .arg(QString::fromStdString(doctorFilter));
+        return results;
+    }
 
-            // Фильтр по врачу
-            if (!doctorFilter.empty() && appointment.doctorType != doctorFilter) {
-                return false;
-            }
+    // Индекс в пределах хранилища и приём у нужного врача
+    auto matchesDoctor = [&](std::size_t appointmentIndex) {
+        if (appointmentIndex >= AppointmentArray.Size()) {
+            qDebug().noquote() << QString("Индекс %1 вне хранилища приёмов").arg(appointmentIndex);
+            return false;
+        }
+        return doctorFilter.empty() || AppointmentArray.doctor(appointmentIndex) == doctorId;
+    };
 
-            return true; // Пока что пропускаем, ФИО проверим отдельно
-        },
-        [&](const Appointment& appointment) {
-            // Находим индекс приёма в массиве
-            std::size_t appointmentIndex = SIZE_MAX;
-            for (std::size_t i = 0; i < AppointmentArray.Size(); ++i) {
-                if (AppointmentArray[i] == appointment) {
-                    appointmentIndex = i;
-                    break;
-                }
-            }
+    // Строка отчёта по приёму; только читает хранилище, вызывается и из потоков обхода
+    auto makeRecord = [](std::size_t appointmentIndex, const Patient* patient) {
+        FullReportRecord record;
+        record.appointmentIndex = appointmentIndex;
+        record.doctorId = AppointmentArray.doctor(appointmentIndex);
+        record.diagnosisId = AppointmentArray.diagnosis(appointmentIndex);
+        record.appointmentDate = Date::fromKey(AppointmentArray.date(appointmentIndex));
+        record.patientPolicy = AppointmentArray.policy(appointmentIndex);
 
-            if (appointmentIndex == SIZE_MAX || appointmentIndex >= appointmentPolicies.size()) {
-                qDebug().noquote() << "Не найден индекс для приёма";
-                return;
-            }
+        if (patient) {
+            record.patientSurname = patient->surname;
+            record.patientName = patient->name;
+            record.patientMiddlename = patient->middlename;
+            record.patientBirthDate = patient->birthDate;
+            record.patientFound = true;
+        } else {
+            record.patientSurname = "НЕ";
+            record.patientName = "НАЙДЕН";
+            record.patientMiddlename = "";
+            record.patientBirthDate = {1, Month::янв, 1900};
+            record.patientFound = false;
+        }
+        return record;
+    };
 
-            // Получаем полис для этого приёма
-            std::string policy = appointmentPolicies[appointmentIndex];
+    // Приём прошёл фильтры — добавляем его в отчёт
+    auto addRecord = [&](std::size_t appointmentIndex, const Patient* patient) {
+        const FullReportRecord& record = results.emplace_back(makeRecord(appointmentIndex, patient));
 
-            // Получаем данные пациента из справочника 1
-            const Patient* patient = hashTable.get(policy);
+        qDebug().noquote() << QString("✓ Добавлен: %1 %2 %3 → %4 у %5")
+                                  .arg(QString::fromStdString(record.patientSurname))
+                                  .arg(QString::fromStdString(record.patientName))
+                                  .arg(QString::fromStdString(record.patientMiddlename))
+                                  .arg(QString::fromStdString(Diagnoses[record.diagnosisId]))
+                                  .arg(QString::fromStdString(DoctorTypes[record.doctorId]));
+    };
 
-            FullReportRecord record;
-            record.appointmentIndex = appointmentIndex;
-            record.doctorType = appointment.doctorType;
-            record.diagnosis = appointment.diagnosis;
-            record.appointmentDate = appointment.appointmentDate;
-            record.patientPolicy = policy;
+    // С фильтром по ФИО отчёт начинается с индекса ФИО: для каждого найденного
+    // пациента обходятся только его приёмы в дереве полисов
+    if (!fioFilter.empty()) {
+        const std::vector<PolicyId>& policies = hashTable.findByFio(fioFilter);
+        qDebug().noquote() << QString("Пациентов с ФИО \"%1\": %2")
+                                  .arg(QString::fromStdString(fioFilter))
+                                  .arg(policies.size());
 
-            if (patient) {
-                record.patientSurname = patient->surname;
-                record.patientName = patient->name;
-                record.patientMiddlename = patient->middlename;
-                record.patientBirthDate = patient->birthDate;
-                record.patientFound = true;
-
-                // Применяем фильтр по ФИО если указан
-                if (!fioFilter.empty()) {
-                    std::string fullFIO = patient->surname + " " + patient->name + " " + patient->middlename;
-                    if (fullFIO != fioFilter) {
-                        return; // Не подходит по ФИО
-                    }
-                }
-            } else {
-                record.patientSurname = "НЕ";
-                record.patientName = "НАЙДЕН";
-                record.patientMiddlename = "";
-                record.patientBirthDate = {1, Month::янв, 1900};
-                record.patientFound = false;
-
-                // Если фильтр по ФИО задан, а пациент не найден - пропускаем
-                if (!fioFilter.empty()) {
-                    return;
-                }
+        for (PolicyId policy : policies) {
+            const Patient* patient = hashTable.get(policy);
+            avlTree.traverseByKey(policy, [&](std::size_t appointmentIndex) {
+                const DateKey date = AppointmentArray.date(appointmentIndex);
+                if (matchesDoctor(appointmentIndex) && date >= fromKey && date <= toKey)
+                    addRecord(appointmentIndex, patient);
+            });
+        }
+        return results;
+    }
+
+    // С фильтром по врачу отчёт берётся из составного индекса (дата, врач):
+    // приёмы врача за день лежат в одном узле. Каждая дата периода стоит
+    // спуска к узлу нужного врача, а за один день это ровно один спуск;
+    // приёмы других врачей не посещаются вовсе
+    if (!doctorFilter.empty()) {
+        const DateDoctorKey last{toKey, doctorId};
+        auto node = dateDoctorTree.lowerBound({fromKey, doctorId});
+        while (node != dateDoctorTree.end() && !(last < node->key)) {
+            const DateKey date = node->key.date;
+            if (node->key.doctor == doctorId) {
+                for (std::size_t appointmentIndex : node->indexList)
+                    addRecord(appointmentIndex, hashTable.get(AppointmentArray.policy(appointmentIndex)));
             }
 
-            results.push_back(record);
-
-            qDebug().noquote() << QString("✓ Добавлен: %1 %2 %3 → %4 у %5")
-                                      .arg(QString::fromStdString(record.patientSurname))
-                                      .arg(QString::fromStdString(record.patientName))
-                                      .arg(QString::fromStdString(record.patientMiddlename))
-                                      .arg(QString::fromStdString(record.diagnosis))
-                                      .arg(QString::fromStdString(record.doctorType));
+            // Врач ещё впереди в этой дате — спуск к нему, иначе — к следующей дате
+            node = node->key.doctor < doctorId
+                       ? dateDoctorTree.lowerBound({date, doctorId})
+                       : dateDoctorTree.upperBound({date, std::numeric_limits<DictId>::max()});
+        }
+        return results;
+    }
+
+    // Число приёмов периода известно заранее по счётчикам поддеревьев
+    const std::size_t inPeriod = dateTree.countInRange(fromKey, toKey);
+
+    qDebug().noquote() << QString("Поиск в дереве отчетов за период: %1 – %2, приёмов: %3")
+                              .arg(fromKey)
+                              .arg(toKey)
+                              .arg(inPeriod);
+
+    // Дерево дат отдаёт только поддеревья периода, их параллельно обходят
+    // потоки пула; строки частей сливаются в порядке дат в results, память
+    // под который выделена один раз. Хранилище и хэш-таблица в это время
+    // только читаются
+    results.reserve(inPeriod);
+    results = dateTree.parallelTraverseRange(
+        fromKey, toKey, std::move(results),
+        [&](const DateTree::Node& node, std::vector<FullReportRecord>& part) {
+            for (std::size_t appointmentIndex : node.indexList)
+                part.push_back(makeRecord(appointmentIndex, hashTable.get(AppointmentArray.policy(appointmentIndex))));
         },
-        AppointmentArray
-        );
+        [](std::vector<FullReportRecord>& into, std::vector<FullReportRecord>&& part) {
+            into.insert(into.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        });
 
+    qDebug().noquote() << QString("Добавлено приёмов за период: %1").arg(results.size());
     return results;
 }
 
@@ -39,14 +39,14 @@ class MainWindow;
 QT_END_NAMESPACE
 
 // Объявляем глобальные массивы как extern
-extern Array<Patient, 1000> PatientArray;
-extern Array<Appointment, 1000> AppointmentArray;
+extern PatientStore PatientArray;
+extern AppointmentStore AppointmentArray;
 
 Month monthFromShortString(const QString& shortMonth);
 
 // Предварительные объявления
 class TreeNodeItem;
-template<typename KeyType, typename T, typename ArrayType>
+template<typename KeyType, typename T, typename ArrayType, bool OrderStatistics>
 struct AVLNode;
 
 class MainWindow : public QMainWindow {
@@ -56,9 +56,6 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
-    // ИСПРАВЛЕНИЕ: Делаем appointmentPolicies публичным для доступа из DateTreeNodeItem
-    std::vector<std::string> appointmentPolicies;
-
 private slots:
     void showSplitSearchDialog();
     void showIntegrityReport();
@@ -78,6 +75,10 @@ private slots:
     void debugDateTreeNodes();      // Отладка узлов дерева дат
 
 private:
+    using PolicyTree = AVLTree<PolicyId, Appointment, AppointmentStore>;
+    using DateTree = AVLTree<DateKey, Appointment, AppointmentStore, NodeArena, true>;  // с порядковыми запросами
+    using DateDoctorTree = AVLTree<DateDoctorKey, Appointment, AppointmentStore>;
+
     enum class CurrentTreeType {
         PolicyTree,    // Дерево по ОМС
         DateTree       // Дерево по датам
@@ -92,12 +93,12 @@ private:
         std::string patientSurname;
         std::string patientName;
         std::string patientMiddlename;
-        std::string patientPolicy;
+        PolicyId patientPolicy;
         Date patientBirthDate;
 
         // Справочник 2 - Приём
-        std::string doctorType;
-        std::string diagnosis;
+        DictId doctorId;
+        DictId diagnosisId;
         Date appointmentDate;
         std::size_t appointmentIndex;
 
@@ -108,7 +109,8 @@ private:
     // UI компоненты
     QLineEdit* fioFilterEdit;
     QLineEdit* doctorFilterEdit;
-    QDateEdit* dateFilterEdit;
+    QDateEdit* dateFilterEdit;     // начало периода
+    QDateEdit* dateToFilterEdit;   // конец периода (включительно)
     QTableWidget *avlTreeTableView;
     QToolBar *toolBar;
     QTabWidget *tabWidget;
@@ -135,25 +137,31 @@ private:
 
     // Структуры данных
     HashTable hashTable;                                                        // Пациенты
-    AVLTree<std::string, Appointment, Array<Appointment, 1000>> avlTree;        // ОМС → приёмы (основное)
-    AVLTree<std::string, Appointment, Array<Appointment, 1000>> dateTree;       // Дата → приёмы (для отчетов)
+    PolicyTree avlTree;                                                         // ОМС → приёмы (основное)
+    DateTree dateTree;                                                          // Дата → приёмы (для отчетов)
+    DateDoctorTree dateDoctorTree;                                              // (Дата, врач) → приёмы (для отчетов)
     std::vector<TreeNodeItem*> treeNodes;
 
+    // Приём индексируется сразу тремя деревьями (ОМС, даты, дата+врач): добавление
+    // и удаление записей хранилища идут только через эти методы
+    std::size_t addAppointmentRecord(const Appointment& appointment);
+    void removeAppointmentRecord(std::size_t index);
+    std::size_t findAppointmentRecord(const Appointment& appointment) const;
+    void rebuildAppointmentIndexes();
+
     // Методы для работы с датами и отчетами
-    std::string dateToString(const Date& date);
-    Date stringToDate(const std::string& dateStr);
-    void buildDateTreeForReport();
     std::vector<FullReportRecord> generateFullReportData(
         const std::string& fioFilter,
         const std::string& doctorFilter,
-        const Date& dateFilter
+        const Date& dateFrom,
+        const Date& dateTo
         );
     void saveFullReportToFile(const QString& filePath, const std::vector<FullReportRecord>& reportData);
 
     // Методы визуализации двух деревьев
-    void drawTreeByPolicy(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* root);
-    void drawTreeByDate(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* root);
-    void drawDateNode(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node,
+    void drawTreeByPolicy(PolicyTree::Node* root);
+    void drawTreeByDate(DateTree::Node* root);
+    void drawDateNode(DateTree::Node* node,
                       qreal x, qreal y, qreal horizontalSpacing, int level);
     void showEmptyTreeMessage(const QString& message);
 
@@ -174,9 +182,11 @@ private:
     void updateTreeVisualization();
     void drawTree();
     void clearTreeVisualization();
-    int calculateTreeHeight(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node);
-    int calculateTreeWidth(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node);
-    void drawNode(AVLNode<std::string, Appointment, Array<Appointment, 1000>>* node,
+    template<typename NodeType>
+    int calculateTreeHeight(NodeType* node);
+    template<typename NodeType>
+    int calculateTreeWidth(NodeType* node);
+    void drawNode(PolicyTree::Node* node,
                   qreal x, qreal y, qreal horizontalSpacing, int level);
 
     // Вспомогательные методы
@@ -185,11 +195,13 @@ private:
     void generateIntegrityReport();
 
     // Методы валидации и проверки
-    bool patientExists(const std::string& policy) const;
-    void deleteAllAppointmentsForPatient(const std::string& policy);
-    bool validateAppointmentData(const std::string& policy, const Appointment& appointment);
-    bool parsePatientLine(const QString& line, std::string& policy, Patient& patient);
-    bool parseAppointmentLine(const QString& line, std::string& policy, Appointment& appointment);
+    bool patientExists(PolicyId policy) const;
+    void deleteAllAppointmentsForPatient(PolicyId policy);
+    bool validateAppointmentData(PolicyId policy, const Appointment& appointment,
+                                 const std::string& doctor, const std::string& diagnosis);
+    bool parsePatientLine(const QString& line, PolicyId& policy, Patient& patient);
+    bool parseAppointmentLine(const QString& line, PolicyId& policy, Appointment& appointment,
+                              QString& doctor, QString& diagnosis);
     bool isValidPolicy(const std::string& policy) const;
 };
 
@@ -0,0 +1,203 @@
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Политики выделения узлов дерева: create(args...) / destroy(node) /
+// reset() / release(). ResetFreesNodes — reset() сам освобождает все узлы,
+// и тривиально разрушаемые узлы дерево перед сбросом не обходит
+// (AVLTree::clear); иначе reset() вызывается, когда все узлы уже разрушены.
+// release() — то же, что reset(), но лишняя память отдаётся системе.
+
+// Каждый узел — отдельный new/delete
+template<typename Node>
+class HeapNodeAllocator
+{
+public:
+    template<typename... Args>
+    Node *create(Args &&...args) { return new Node(std::forward<Args>(args)...); }
+
+    void destroy(Node *node) { delete node; }
+
+    static constexpr bool ResetFreesNodes = false;
+    void reset() {}
+    void release() {}
+};
+
+// Арена узлов одного дерева: память берётся блоками по SlabSize узлов,
+// узлы нарезаются из блока подряд, освобождённые уходят в список свободных
+// и переиспользуются первыми. reset() возвращает всю арену в начальное
+// состояние за O(1) по числу узлов: блоки не отдаются системе, и
+// перестроенное дерево снова ложится в них подряд, в порядке вставки.
+// release() оставляет только первый блок.
+template<typename Node, std::size_t SlabSize = 256>
+class NodeArena
+{
+    static_assert(SlabSize > 0, "Блок арены не может быть пустым");
+
+    union Cell {
+        Cell *next; // ячейка в списке свободных
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+public:
+    NodeArena() = default;
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    template<typename... Args>
+    Node *create(Args &&...args)
+    {
+        Cell *cell = take();
+        return ::new (static_cast<void *>(cell->storage)) Node(std::forward<Args>(args)...);
+    }
+
+    void destroy(Node *node)
+    {
+        node->~Node();
+        Cell *cell = reinterpret_cast<Cell *>(node);
+        cell->next = m_free;
+        m_free = cell;
+    }
+
+    static constexpr bool ResetFreesNodes = true;
+
+    void reset()
+    {
+        m_free = nullptr;
+        m_slab = 0;
+        m_used = 0;
+    }
+
+    void release()
+    {
+        reset();
+        if (m_slabs.size() > 1)
+            m_slabs.resize(1);
+    }
+
+    std::size_t slabCount() const { return m_slabs.size(); }
+
+private:
+    Cell *take()
+    {
+        if (m_free)
+        {
+            Cell *cell = m_free;
+            m_free = cell->next;
+            return cell;
+        }
+
+        if (m_used == SlabSize)
+        {
+            ++m_slab;
+            m_used = 0;
+        }
+        if (m_slab == m_slabs.size())
+            m_slabs.push_back(std::make_unique<Cell[]>(SlabSize));
+
+        return &m_slabs[m_slab][m_used++];
+    }
+
+    std::vector<std::unique_ptr<Cell[]>> m_slabs;
+    Cell *m_free{nullptr};
+    std::size_t m_slab{0}; // блок, из которого нарезаются новые узлы
+    std::size_t m_used{0}; // занято ячеек в нём
+};
+
+// Арена буферов, вынесенных из узлов в кучу (списки индексов SmallVector).
+// Буфер ёмкостью 2^k элементов нарезается из общего блока, освобождённый
+// уходит в список свободных своего размера. Буфер больше блока выделяется
+// отдельно и тоже переиспользуется. reset() забывает все буферы сразу —
+// узлы при очистке дерева ничего не освобождают; release() оставляет
+// только первый блок.
+template<typename T, std::size_t BlockSize = 4096>
+class SpillArena
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Арена хранит только тривиально копируемые элементы");
+    static_assert(std::has_single_bit(BlockSize), "Размер блока — степень двойки");
+
+    // Свободный буфер хранит в себе указатель на следующий
+    static constexpr std::size_t MinClass = std::bit_width((sizeof(T *) + sizeof(T) - 1) / sizeof(T) - 1);
+
+public:
+    SpillArena() = default;
+
+    SpillArena(const SpillArena &) = delete;
+    SpillArena &operator=(const SpillArena &) = delete;
+
+    T *allocate(std::size_t capacity)
+    {
+        std::size_t sizeClass = classOf(capacity);
+        if (T *buffer = m_free[sizeClass])
+        {
+            std::memcpy(&m_free[sizeClass], buffer, sizeof(T *));
+            return buffer;
+        }
+
+        std::size_t size = std::size_t{1} << sizeClass;
+        if (size > BlockSize)
+            return m_large.emplace_back(std::make_unique_for_overwrite<T[]>(size)).get();
+
+        if (m_used + size > BlockSize)
+        {
+            ++m_block;
+            m_used = 0;
+        }
+        if (m_block == m_blocks.size())
+            m_blocks.push_back(std::make_unique_for_overwrite<T[]>(BlockSize));
+
+        T *buffer = m_blocks[m_block].get() + m_used;
+        m_used += size;
+        return buffer;
+    }
+
+    void deallocate(T *buffer, std::size_t capacity)
+    {
+        std::size_t sizeClass = classOf(capacity);
+        std::memcpy(buffer, &m_free[sizeClass], sizeof(T *));
+        m_free[sizeClass] = buffer;
+    }
+
+    // Буферы крупнее блока — единицы, их освобождение в счёт не идёт
+    void reset()
+    {
+        m_free.fill(nullptr);
+        m_large.clear();
+        m_block = 0;
+        m_used = 0;
+    }
+
+    void release()
+    {
+        reset();
+        if (m_blocks.size() > 1)
+            m_blocks.resize(1);
+    }
+
+    std::size_t blockCount() const { return m_blocks.size(); }
+
+private:
+    static std::size_t classOf(std::size_t capacity)
+    {
+        return std::max<std::size_t>(std::bit_width(capacity - 1), MinClass);
+    }
+
+    std::vector<std::unique_ptr<T[]>> m_blocks;
+    std::vector<std::unique_ptr<T[]>> m_large;
+    std::array<T *, 64> m_free{};
+    std::size_t m_block{0}; // блок, из которого нарезаются новые буферы
+    std::size_t m_used{0};  // занято элементов в нём
+};
+
+#endif // NODEARENA_H
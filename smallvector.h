@@ -0,0 +1,101 @@
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Непрерывный массив с встроенным буфером на InlineCapacity элементов.
+// Пока элементов мало, они лежат прямо в объекте-владельце (узле дерева),
+// и обход списка — линейное чтение без переходов по указателям; в кучу
+// данные уходят, только когда встроенный буфер переполнен.
+// Рассчитан на тривиально копируемые элементы (индексы записей).
+// Вынесенный буфер берётся у пула владельца (SpillArena дерева:
+// allocate(capacity) / deallocate(buffer, capacity)). Сам вектор его не
+// освобождает и разрушается тривиально: буфер возвращает release(pool)
+// или сброс пула целиком.
+template<typename T, std::size_t InlineCapacity>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector хранит только тривиально копируемые элементы");
+    static_assert(InlineCapacity > 0, "Встроенный буфер не может быть пустым");
+
+public:
+    SmallVector() = default;
+
+    // Позиции элементов адресуются снаружи (обратные ссылки дерева), копировать нельзя
+    SmallVector(const SmallVector &) = delete;
+    SmallVector &operator=(const SmallVector &) = delete;
+
+    template<typename Pool>
+    void push_back(const T &value, Pool &pool)
+    {
+        if (m_size == m_capacity)
+            grow(m_capacity * 2, pool);
+        data()[m_size++] = value;
+    }
+
+    void pop_back() { --m_size; }
+
+    // Удаление со сдвигом хвоста: порядок остальных элементов сохраняется
+    void erase(std::size_t pos)
+    {
+        T *items = data();
+        std::memmove(items + pos, items + pos + 1, (m_size - pos - 1) * sizeof(T));
+        --m_size;
+    }
+
+    void clear() { m_size = 0; }
+
+    // Отдаёт вынесенный буфер пулу; вектор снова пуст и встроен
+    template<typename Pool>
+    void release(Pool &pool)
+    {
+        if (isSpilled())
+            pool.deallocate(m_heap, m_capacity);
+        m_size = 0;
+        m_capacity = InlineCapacity;
+    }
+
+    T &operator[](std::size_t pos) { return data()[pos]; }
+    const T &operator[](std::size_t pos) const { return data()[pos]; }
+
+    T &back() { return data()[m_size - 1]; }
+    const T &back() const { return data()[m_size - 1]; }
+
+    T *begin() { return data(); }
+    T *end() { return data() + m_size; }
+    const T *begin() const { return data(); }
+    const T *end() const { return data() + m_size; }
+
+    T *data() { return isSpilled() ? m_heap : m_inline; }
+    const T *data() const { return isSpilled() ? m_heap : m_inline; }
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    bool isSpilled() const { return m_capacity > InlineCapacity; }
+
+private:
+    template<typename Pool>
+    void grow(std::size_t capacity, Pool &pool)
+    {
+        T *heap = pool.allocate(capacity);
+        std::copy(begin(), end(), heap);
+        if (isSpilled())
+            pool.deallocate(m_heap, m_capacity);
+        m_heap = heap;
+        m_capacity = static_cast<std::uint32_t>(capacity);
+    }
+
+    union {
+        T m_inline[InlineCapacity];
+        T *m_heap;
+    };
+    std::uint32_t m_size{0};
+    std::uint32_t m_capacity{InlineCapacity};
+};
+
+#endif // SMALLVECTOR_H
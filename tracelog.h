@@ -0,0 +1,286 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include "types.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// Трассировка структур данных.
+// Уровень и категории задаются при компиляции (TRACE_LEVEL, TRACE_CATEGORIES):
+// выключенный вызов TRACE(...) не порождает кода вовсе. Включённые события
+// не форматируются на месте — в кольцевой буфер кладутся указатель на
+// строковый литерал и до четырёх целых аргументов (один из них может быть
+// строкой — копируется её начало), а строку собирает и пишет в qDebug()
+// фоновый поток.
+
+// 0 — выключено, 1 — ошибки, 2 — операции, 3 — шаги алгоритмов, 4 — всё
+#ifndef TRACE_LEVEL
+#ifdef NDEBUG
+#define TRACE_LEVEL 0
+#else
+#define TRACE_LEVEL 4
+#endif
+#endif
+
+// Битовая маска категорий tracelog::Category
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES 0xFFFFFFFFu
+#endif
+
+namespace tracelog {
+
+enum class Level : std::uint8_t { Error = 1, Info = 2, Debug = 3, Trace = 4 };
+
+enum class Category : std::uint32_t {
+    Hash = 1u << 0,  // хэш-таблица пациентов
+    Tree = 1u << 1,  // AVL-деревья
+    List = 1u << 2,  // списки индексов
+    Store = 1u << 3, // хранилища записей
+};
+
+constexpr bool enabled(Level level, Category category)
+{
+    return static_cast<int>(level) <= TRACE_LEVEL
+           && (static_cast<std::uint32_t>(category) & TRACE_CATEGORIES) != 0;
+}
+
+// Аргумент события — целое число; ключи приводятся к нему здесь
+template<std::integral T>
+constexpr std::int64_t arg(T value) { return static_cast<std::int64_t>(value); }
+
+template<typename T>
+    requires std::is_enum_v<T>
+constexpr std::int64_t arg(T value) { return static_cast<std::int64_t>(value); }
+
+constexpr std::int64_t arg(PolicyId value) { return static_cast<std::int64_t>(value.value); }
+
+// ГГГГММДДnnnnnn: дата и номер врача (шесть младших цифр)
+constexpr std::int64_t arg(DateDoctorKey value)
+{
+    return static_cast<std::int64_t>(value.date) * 1000000 + value.doctor % 1000000;
+}
+
+struct Event
+{
+    static constexpr std::size_t TextSize = 32;
+    static constexpr std::uint8_t NoText = 0xFF;
+
+    const char *message; // литерал с подстановками %1..%4
+    std::int64_t args[4];
+    char text[TextSize];   // начало строкового аргумента
+    std::uint8_t textLength;
+    std::uint8_t textArg;  // номер строкового аргумента или NoText
+    bool textTruncated;
+    std::uint8_t argCount;
+    Level level;
+    Category category;
+};
+
+template<typename T>
+concept TextArg = std::convertible_to<const T &, std::string_view>;
+
+template<typename T>
+    requires(!TextArg<T>)
+void put(Event &event, std::uint8_t i, const T &value) { event.args[i] = arg(value); }
+
+// Строка копируется в событие целиком или началом не длиннее TextSize байт,
+// обрезанным по границе символа UTF-8
+inline void put(Event &event, std::uint8_t i, std::string_view value)
+{
+    std::size_t length = std::min(value.size(), Event::TextSize);
+    if (length < value.size())
+        while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xC0) == 0x80)
+            --length;
+
+    std::copy_n(value.data(), length, event.text);
+    event.textLength = static_cast<std::uint8_t>(length);
+    event.textTruncated = length < value.size();
+    event.textArg = i;
+}
+
+// Кольцевой буфер на много писателей и одного читателя (схема Вьюкова:
+// у каждой ячейки свой счётчик последовательности, писатели захватывают
+// ячейки через CAS без блокировок). Переполненный буфер не ждёт читателя —
+// событие отбрасывается и учитывается в dropped().
+class Ring
+{
+public:
+    static constexpr std::size_t Capacity = 4096;
+    static_assert((Capacity & (Capacity - 1)) == 0, "Ёмкость буфера должна быть степенью двойки");
+
+    Ring()
+    {
+        for (std::size_t i = 0; i < Capacity; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const Event &event)
+    {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = m_cells[pos & (Capacity - 1)];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.event = event;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Только для потока-читателя
+    bool pop(Event &event)
+    {
+        Cell &cell = m_cells[m_head & (Capacity - 1)];
+        std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != m_head + 1)
+            return false;
+
+        event = cell.event;
+        cell.sequence.store(m_head + Capacity, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+    std::size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        Event event;
+    };
+
+    std::array<Cell, Capacity> m_cells;
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    alignas(64) std::size_t m_head{0};
+    std::atomic<std::size_t> m_dropped{0};
+};
+
+// Буфер и фоновый поток, который раз в несколько миллисекунд
+// вычитывает события и печатает их; при завершении дочитывает остаток
+class Sink
+{
+public:
+    static Sink &instance()
+    {
+        static Sink sink;
+        return sink;
+    }
+
+    void push(const Event &event) { m_ring.push(event); }
+
+    ~Sink()
+    {
+        m_worker.request_stop();
+        m_worker.join();
+        drain();
+    }
+
+private:
+    Sink() : m_worker([this](std::stop_token stop) { run(stop); }) {}
+
+    void run(std::stop_token stop)
+    {
+        while (!stop.stop_requested())
+        {
+            if (!drain())
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    bool drain()
+    {
+        bool any = false;
+        Event event;
+        while (m_ring.pop(event))
+        {
+            any = true;
+            print(event);
+        }
+
+        std::size_t dropped = m_ring.dropped();
+        if (dropped != m_reportedDropped)
+        {
+            qDebug().noquote() << QString("[trace] пропущено событий: %1").arg(dropped - m_reportedDropped);
+            m_reportedDropped = dropped;
+        }
+        return any;
+    }
+
+    static void print(const Event &event)
+    {
+        QString text = QString::fromUtf8(event.message);
+        for (std::uint8_t i = 0; i < event.argCount; ++i)
+        {
+            if (i == event.textArg)
+                text = text.arg(QString::fromUtf8(event.text, static_cast<qsizetype>(event.textLength))
+                                + (event.textTruncated ? QString("…") : QString()));
+            else
+                text = text.arg(static_cast<qlonglong>(event.args[i]));
+        }
+        qDebug().noquote() << text;
+    }
+
+    Ring m_ring;
+    std::size_t m_reportedDropped{0};
+    std::jthread m_worker;
+};
+
+template<typename... Args>
+void post(Level level, Category category, const char *message, const Args &...args)
+{
+    static_assert(sizeof...(Args) <= 4, "Событие трассировки принимает не больше четырёх аргументов");
+    static_assert((0 + ... + TextArg<Args>) <= 1, "Событие трассировки принимает не больше одной строки");
+
+    Event event;
+    event.message = message;
+    event.textLength = 0;
+    event.textArg = Event::NoText;
+    event.textTruncated = false;
+    event.argCount = static_cast<std::uint8_t>(sizeof...(Args));
+    event.level = level;
+    event.category = category;
+
+    std::uint8_t i = 0;
+    (put(event, i++, args), ...);
+    Sink::instance().push(event);
+}
+
+} // namespace tracelog
+
+// TRACE(Debug, Hash, "Позиция %1", pos): аргументы — целые, PolicyId, enum
+// или одна строка
+#define TRACE(level, category, ...)                                                              \
+    do {                                                                                         \
+        if constexpr (::tracelog::enabled(::tracelog::Level::level, ::tracelog::Category::category)) \
+            ::tracelog::post(::tracelog::Level::level, ::tracelog::Category::category, __VA_ARGS__); \
+    } while (0)
+
+#endif // TRACELOG_H
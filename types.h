@@ -1,6 +1,9 @@
 #ifndef TYPES_H
 #define TYPES_H
+#include <compare>
 #include <string>
+#include <string_view>
+#include <cstdint>
 enum class Month
 {
     янв = 1,
@@ -17,15 +20,88 @@ enum class Month
     дек = 12,
 };
 
+// Упакованный ключ даты ГГГГММДД: порядок чисел совпадает с порядком дат
+using DateKey = std::uint32_t;
+
 struct Date
 {
     int day;
     Month month;
     int year;
-    auto operator<=>(const Date &other) const = default;
+
+    constexpr DateKey toKey() const
+    {
+        return static_cast<DateKey>(year) * 10000u +
+               static_cast<DateKey>(month) * 100u +
+               static_cast<DateKey>(day);
+    }
+
+    static constexpr Date fromKey(DateKey key)
+    {
+        return {static_cast<int>(key % 100),
+                static_cast<Month>(key / 100 % 100),
+                static_cast<int>(key / 10000)};
+    }
+
+    // Сравнение по упакованному ключу — хронологический порядок
+    constexpr auto operator<=>(const Date &other) const { return toKey() <=> other.toKey(); }
+    constexpr bool operator==(const Date &other) const = default;
 
 };
 
+// Полис ОМС: 16 цифр хранятся одним 64-битным числом.
+// Разбирается один раз при вводе, дальше используется как ключ
+// хэш-таблицы и дерева (сравнение — одно целочисленное сравнение).
+struct PolicyId
+{
+    static constexpr std::size_t Digits = 16;
+
+    std::uint64_t value{0};
+
+    // Разбор строки полиса: ровно 16 цифр, пробелы между группами допускаются.
+    // Нулевой полис считается некорректным. UTF-16 — для текста из интерфейса
+    // (QStringView), чтобы не собирать ради разбора временную std::string.
+    static bool parse(std::string_view str, PolicyId &out) { return parseUnits(str, out); }
+    static bool parse(std::u16string_view str, PolicyId &out) { return parseUnits(str, out); }
+
+    bool isValid() const { return value != 0; }
+
+    // 16 цифр с ведущими нулями
+    std::string toString() const
+    {
+        std::string result(Digits, '0');
+        std::uint64_t rest = value;
+        for (std::size_t i = Digits; i > 0 && rest > 0; --i)
+        {
+            result[i - 1] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        }
+        return result;
+    }
+
+    auto operator<=>(const PolicyId &other) const = default;
+
+private:
+    template<typename Char>
+    static bool parseUnits(std::basic_string_view<Char> str, PolicyId &out)
+    {
+        std::uint64_t result = 0;
+        std::size_t digits = 0;
+        for (Char c : str)
+        {
+            if (c == Char(' '))
+                continue;
+            if (c < Char('0') || c > Char('9') || ++digits > Digits)
+                return false;
+            result = result * 10 + static_cast<std::uint64_t>(c - Char('0'));
+        }
+        if (digits != Digits || result == 0)
+            return false;
+        out.value = result;
+        return true;
+    }
+};
+
 struct Patient {
     std::string name, surname, middlename;
     Date birthDate;
@@ -38,14 +114,72 @@ struct Patient {
     }
 };
 
+// Перекодирует UTF-16 (текст из интерфейса) в UTF-8 в буфер out ёмкостью
+// capacity байт. Возвращает длину или npos, если текст не поместился;
+// на одну единицу UTF-16 приходится не больше трёх байт UTF-8.
+// Непарный суррогат заменяется на U+FFFD.
+inline std::size_t utf8Into(std::u16string_view text, char *out, std::size_t capacity)
+{
+    std::size_t length = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        char32_t c = text[i];
+        if (c >= 0xD800 && c <= 0xDFFF)
+        {
+            if (c <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF)
+                c = 0x10000 + ((c - 0xD800) << 10) + (text[++i] - 0xDC00);
+            else
+                c = 0xFFFD;
+        }
+
+        std::size_t bytes = c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+        if (capacity - length < bytes)
+            return std::string_view::npos;
+
+        if (bytes == 1)
+        {
+            out[length++] = static_cast<char>(c);
+            continue;
+        }
+        static constexpr unsigned char lead[] = {0, 0, 0xC0, 0xE0, 0xF0};
+        out[length] = static_cast<char>(lead[bytes] | (c >> (6 * (bytes - 1))));
+        for (std::size_t k = 1; k < bytes; ++k)
+            out[length + k] = static_cast<char>(0x80 | ((c >> (6 * (bytes - 1 - k))) & 0x3F));
+        length += bytes;
+    }
+    return length;
+}
+
+inline std::string toUtf8(std::u16string_view text)
+{
+    std::string result(text.size() * 3, '\0');
+    result.resize(utf8Into(text, result.data(), result.size()));
+    return result;
+}
+
+// Номер значения в словаре строк (см. dictionary.h)
+using DictId = std::uint32_t;
+
+// Составной ключ индекса отчётов: дата, внутри даты — врач.
+// Сравнение лексикографическое, как у кортежа (date, doctor)
+struct DateDoctorKey
+{
+    DateKey date;
+    DictId doctor;
+
+    auto operator<=>(const DateDoctorKey &) const = default;
+};
+
 struct Appointment {
-    std::string doctorType, diagnosis;
+    DictId doctorId, diagnosisId;   // DoctorTypes / Diagnoses
     Date appointmentDate;
+    PolicyId policy;                // пациент, к которому относится приём
 
     bool operator==(const Appointment& other) const {
-        return doctorType == other.doctorType &&
-               diagnosis == other.diagnosis &&
-               appointmentDate == other.appointmentDate;
+        return doctorId == other.doctorId &&
+               diagnosisId == other.diagnosisId &&
+               appointmentDate == other.appointmentDate &&
+               policy == other.policy;
     }
 };
 enum class Status
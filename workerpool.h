@@ -0,0 +1,118 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Общий пул потоков параллельных обходов. Потоки заводятся один раз, при
+// первом обращении, и ждут заданий; вызывающий поток работает наравне
+// с ними, поэтому в пуле на один поток меньше, чем ядер.
+// Задание — work(worker) для worker = 0..workers-1: 0 выполняет
+// вызывающий поток, остальные номера разбирают потоки пула; run()
+// возвращается, когда все номера отработали. Задания от разных потоков
+// выполняются по очереди; вызов run() из задания выполняется на месте.
+class WorkerPool
+{
+public:
+    static WorkerPool &instance()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Потоков на задание вместе с вызывающим
+    std::size_t threadCount() const { return m_threads.size() + 1; }
+
+    template<typename Work>
+    void run(std::size_t workers, Work &work)
+    {
+        workers = std::min(workers, threadCount());
+        if (workers <= 1 || t_inJob)
+        {
+            work(0);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(m_submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_invoke = [](void *context, std::size_t worker) { (*static_cast<Work *>(context))(worker); };
+            m_context = &work;
+            m_nextWorker = 1;
+            m_workers = workers;
+            m_pending = workers - 1;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        // Пока идёт задание, вложенный run() из рабочего 0 выполняется на месте
+        t_inJob = true;
+        work(0);
+        t_inJob = false;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_context = nullptr;
+    }
+
+private:
+    WorkerPool()
+    {
+        unsigned helpers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        m_threads.reserve(helpers);
+        for (unsigned i = 0; i < helpers; ++i)
+            m_threads.emplace_back([this](std::stop_token stop) { loop(stop); });
+    }
+
+    // Поток ждёт нового задания и забирает в нём свободный номер;
+    // если номера уже разобраны, ждёт следующего
+    void loop(std::stop_token stop)
+    {
+        t_inJob = true;
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            if (!m_wake.wait(lock, stop, [&] { return m_generation != seen; }))
+                return;
+            seen = m_generation;
+            if (m_nextWorker >= m_workers)
+                continue;
+
+            std::size_t worker = m_nextWorker++;
+            lock.unlock();
+            m_invoke(m_context, worker);
+            lock.lock();
+            if (--m_pending == 0)
+                m_done.notify_one();
+        }
+    }
+
+    // Поток выполняет задание пула (свой поток пула или рабочий 0)
+    static inline thread_local bool t_inJob = false;
+
+    std::mutex m_submitMutex;
+    std::mutex m_mutex;
+    std::condition_variable_any m_wake;
+    std::condition_variable m_done;
+    void (*m_invoke)(void *, std::size_t){nullptr};
+    void *m_context{nullptr};
+    std::size_t m_nextWorker{0};
+    std::size_t m_workers{0};
+    std::size_t m_pending{0};
+    std::uint64_t m_generation{0};
+    // Последним членом: потоки останавливаются и присоединяются раньше,
+    // чем разрушаются мьютекс и условные переменные
+    std::vector<std::jthread> m_threads;
+};
+
+#endif // WORKERPOOL_H